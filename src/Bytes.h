@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Functions for writing and reading little-endian numbers in our files.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Beginning of the namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace Bytes {
+
+
+typedef std::vector < unsigned char > Buffer;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Append the numbers as little-endian bytes.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void put ( Buffer &bytes, std::uint64_t value, unsigned int size )
+{
+	for ( unsigned int i = 0; i < size; ++i )
+	{
+		bytes.push_back ( static_cast < unsigned char > ( ( value >> ( 8 * i ) ) & 0xff ) );
+	}
+}
+inline void put32 ( Buffer &bytes, std::uint32_t value ) { put ( bytes, value, 4 ); }
+inline void put64 ( Buffer &bytes, std::uint64_t value ) { put ( bytes, value, 8 ); }
+inline void putDouble ( Buffer &bytes, double value ) { put64 ( bytes, std::bit_cast < std::uint64_t > ( value ) ); }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the little-endian numbers at the position and move past them.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline std::uint64_t get ( const Buffer &bytes, std::size_t &pos, unsigned int size )
+{
+	if ( ( pos + size ) > bytes.size() )
+	{
+		throw std::runtime_error ( "File is too short" );
+	}
+	std::uint64_t value = 0;
+	for ( unsigned int i = 0; i < size; ++i )
+	{
+		value |= ( static_cast < std::uint64_t > ( bytes[pos + i] ) << ( 8 * i ) );
+	}
+	pos += size;
+	return value;
+}
+inline std::uint32_t get32 ( const Buffer &bytes, std::size_t &pos ) { return static_cast < std::uint32_t > ( get ( bytes, pos, 4 ) ); }
+inline std::uint64_t get64 ( const Buffer &bytes, std::size_t &pos ) { return get ( bytes, pos, 8 ); }
+inline double getDouble ( const Buffer &bytes, std::size_t &pos ) { return std::bit_cast < double > ( get64 ( bytes, pos ) ); }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the little-endian number at the pointer. The caller makes sure the
+//	eight bytes are there. Compilers make this one load when they can.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline std::uint64_t get64 ( const unsigned char *bytes )
+{
+	std::uint64_t value = 0;
+	for ( unsigned int i = 0; i < 8; ++i )
+	{
+		value |= ( static_cast < std::uint64_t > ( bytes[i] ) << ( 8 * i ) );
+	}
+	return value;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Read exactly the number of bytes or throw.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void read ( std::ifstream &in, const std::string &file, unsigned char *bytes, std::size_t size )
+{
+	in.read ( reinterpret_cast < char * > ( bytes ), size );
+	if ( ( static_cast < std::streamsize > ( size ) ) != in.gcount() )
+	{
+		std::ostringstream out;
+		out << "Read " << in.gcount() << " bytes from " << file << " but expected " << size;
+		throw std::runtime_error ( out.str() );
+	}
+}
+inline void read ( std::ifstream &in, const std::string &file, Buffer &bytes )
+{
+	read ( in, file, bytes.data(), bytes.size() );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	End of the namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Bytes
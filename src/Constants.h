@@ -0,0 +1,36 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Numbers that the files, the cache, and the terrain all have to agree on.
+//	This has no other includes, so it is cheap to include anywhere.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Beginning of the namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace Constants {
+
+
+// The size of a cell and of one step in height, in meters, when the input
+// does not say.
+constexpr double DEFAULT_HORIZONTAL_RESOLUTION = 30;
+constexpr double DEFAULT_VERTICAL_RESOLUTION = 11;
+
+// Change this when the answers could change, so that saved answers are not
+// used any more.
+constexpr unsigned int ENGINE_VERSION = 2;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	End of the namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Constants
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A fast 64-bit hash of a stream of bytes. It takes eight bytes at a time
+//	in four lanes, which is much faster than one byte at a time. The answer
+//	only depends on the bytes, not on how they are split between calls or
+//	the byte order of the machine. It is not meant for security.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Bytes.h"
+#include "Random.h"
+#include "Tools.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The class that hashes the bytes.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class Hasher
+{
+public:
+
+	Hasher() :
+		_lanes { 1, 2, 3, 4 },
+		_block(),
+		_blockSize ( 0 ),
+		_total ( 0 )
+	{
+	}
+
+	// Add the bytes.
+	void update ( const void *data, std::size_t size )
+	{
+		const unsigned char *bytes = static_cast < const unsigned char * > ( data );
+		_total += size;
+
+		// Finish the block we started last time.
+		if ( _blockSize > 0 )
+		{
+			const std::size_t needed = std::min ( size, BLOCK_SIZE - _blockSize );
+			std::memcpy ( _block + _blockSize, bytes, needed );
+			_blockSize += needed;
+			bytes += needed;
+			size -= needed;
+
+			if ( _blockSize < BLOCK_SIZE )
+			{
+				return;
+			}
+
+			this->_addBlock ( _block );
+			_blockSize = 0;
+		}
+
+		// Take whole blocks straight from the input.
+		for ( ; size >= BLOCK_SIZE; bytes += BLOCK_SIZE, size -= BLOCK_SIZE )
+		{
+			this->_addBlock ( bytes );
+		}
+
+		// Save what is left for next time.
+		std::memcpy ( _block, bytes, size );
+		_blockSize = size;
+	}
+
+	// Get the hash of all the bytes so far.
+	std::uint64_t getValue() const
+	{
+		std::uint64_t answer = Tools::hash ( _block, _blockSize );
+		for ( unsigned int k = 0; k < 4; ++k )
+		{
+			answer = Random::mix ( answer ^ _lanes[k] );
+		}
+		return Random::mix ( answer ^ _total );
+	}
+
+private:
+
+	static constexpr std::size_t BLOCK_SIZE = 32;
+
+	void _addBlock ( const unsigned char *bytes )
+	{
+		for ( unsigned int k = 0; k < 4; ++k )
+		{
+			_lanes[k] = Random::mix ( _lanes[k] ^ Bytes::get64 ( bytes + ( 8 * k ) ) );
+		}
+	}
+
+	std::uint64_t _lanes[4];
+	unsigned char _block[BLOCK_SIZE];
+	std::size_t _blockSize;
+	std::uint64_t _total;
+};
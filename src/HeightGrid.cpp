@@ -0,0 +1,378 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A grid of heights that is stored in segments of whole rows, so that very
+//	large height maps are not one big allocation.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HeightGrid.h"
+#include "Bytes.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid::HeightGrid() :
+	_numX ( 0 ),
+	_numY ( 0 ),
+	_rowsPerSegment ( 0 ),
+	_minHeight ( std::numeric_limits < std::uint8_t >::max() ),
+	_maxHeight ( std::numeric_limits < std::uint8_t >::min() ),
+	_owned(),
+	_segments()
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid::HeightGrid ( unsigned int numX, unsigned int numY, HeightsView heights ) :
+	_numX ( numX ),
+	_numY ( numY ),
+	_rowsPerSegment ( numY ),
+	_minHeight ( std::numeric_limits < std::uint8_t >::max() ),
+	_maxHeight ( std::numeric_limits < std::uint8_t >::min() ),
+	_owned(),
+	_segments()
+{
+	this->_checkSize ( heights.size() );
+	this->_addHeightRange ( heights );
+	_segments.push_back ( Segment { heights, 0, numX } );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid::HeightGrid ( unsigned int numX, unsigned int numY, Heights &&heights ) :
+	_numX ( numX ),
+	_numY ( numY ),
+	_rowsPerSegment ( numY ),
+	_minHeight ( std::numeric_limits < std::uint8_t >::max() ),
+	_maxHeight ( std::numeric_limits < std::uint8_t >::min() ),
+	_owned(),
+	_segments()
+{
+	this->_checkSize ( heights.size() );
+	this->_addHeightRange ( heights );
+
+	// The vector's buffer moves with it, so the view is still good.
+	_segments.push_back ( Segment { HeightsView ( heights ), 0, numX } );
+	_owned.push_back ( std::move ( heights ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid::HeightGrid ( unsigned int numX, unsigned int numY, unsigned int rowsPerSegment ) :
+	HeightGrid ( numX, numY, rowsPerSegment, std::numeric_limits < std::uint8_t >::max(), std::numeric_limits < std::uint8_t >::min() )
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid::HeightGrid ( unsigned int numX, unsigned int numY, unsigned int rowsPerSegment, std::uint8_t minHeight, std::uint8_t maxHeight ) :
+	_numX ( numX ),
+	_numY ( numY ),
+	_rowsPerSegment ( rowsPerSegment ),
+	_minHeight ( minHeight ),
+	_maxHeight ( maxHeight ),
+	_owned(),
+	_segments()
+{
+	if ( 0 == _rowsPerSegment )
+	{
+		throw std::invalid_argument ( "Rows per segment must be greater than zero" );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Add the next segment of rows.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void HeightGrid::addSegment ( unsigned int firstColumn, unsigned int numColumns, Heights &&heights )
+{
+	// The rows this segment covers.
+	const std::size_t row = _segments.size() * static_cast < std::size_t > ( _rowsPerSegment );
+	if ( row >= _numY )
+	{
+		std::ostringstream out;
+		out << "Segment " << _segments.size() << " is past the last row " << ( _numY - 1 );
+		throw std::out_of_range ( out.str() );
+	}
+	const std::size_t numRows = std::min < std::size_t > ( _rowsPerSegment, _numY - row );
+
+	if ( ( firstColumn > _numX ) || ( numColumns > ( _numX - firstColumn ) ) )
+	{
+		std::ostringstream out;
+		out << "Columns " << firstColumn << " to " << ( static_cast < std::size_t > ( firstColumn ) + numColumns ) << " are out of range for numX = " << _numX;
+		throw std::out_of_range ( out.str() );
+	}
+
+	if ( heights.size() != ( numRows * numColumns ) )
+	{
+		std::ostringstream out;
+		out << "Given " << heights.size() << " heights for segment " << _segments.size() << " but expected " << ( numRows * numColumns );
+		throw std::invalid_argument ( out.str() );
+	}
+
+	// The vector's buffer moves with it, so the view is still good.
+	this->_addHeightRange ( heights );
+	_segments.push_back ( Segment { HeightsView ( heights ), firstColumn, numColumns } );
+	_owned.push_back ( std::move ( heights ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make sure the number of heights matches the size.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void HeightGrid::_checkSize ( std::size_t size ) const
+{
+	if ( size != this->getNumCells() )
+	{
+		std::ostringstream out;
+		out << "Given " << size << " heights but expected " << this->getNumCells();
+		throw std::invalid_argument ( out.str() );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Grow the range of heights to include the given ones.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void HeightGrid::_addHeightRange ( HeightsView heights )
+{
+	if ( !heights.empty() )
+	{
+		const auto range = std::minmax_element ( heights.begin(), heights.end() );
+		_minHeight = std::min ( _minHeight, *range.first );
+		_maxHeight = std::max ( _maxHeight, *range.second );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make a grid that looks at our heights.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid HeightGrid::borrow() const
+{
+	HeightGrid grid;
+	grid._numX = _numX;
+	grid._numY = _numY;
+	grid._rowsPerSegment = _rowsPerSegment;
+	grid._minHeight = _minHeight;
+	grid._maxHeight = _maxHeight;
+	grid._segments = _segments;
+	return grid;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the number of rows in each segment for a grid of the given size.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int HeightGrid::getRowsPerSegment ( unsigned int numX, unsigned int numY )
+{
+	return static_cast < unsigned int > ( std::clamp < std::size_t > ( SEGMENT_SIZE / std::max ( numX, 1u ), 1, std::max ( numY, 1u ) ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the bytes of heights this grid owns. A borrowed grid owns none.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t HeightGrid::getOwnedBytes() const
+{
+	std::size_t bytes = 0;
+	for ( const Heights &heights : _owned )
+	{
+		bytes += heights.capacity();
+	}
+	return bytes;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the row of heights.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid::HeightsView HeightGrid::getRow ( unsigned int i ) const
+{
+	return this->getRow ( i, 0, _numX );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the given columns of the row of heights.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid::HeightsView HeightGrid::getRow ( unsigned int i, unsigned int first, unsigned int count ) const
+{
+	if ( ( i >= _numY ) || ( ( i / _rowsPerSegment ) >= _segments.size() ) )
+	{
+		std::ostringstream out;
+		out << "Row " << i << " is out of range for numY = " << _numY;
+		throw std::out_of_range ( out.str() );
+	}
+
+	const Segment &segment = _segments[i / _rowsPerSegment];
+	if ( ( first < segment.firstColumn ) || ( count > segment.numColumns ) || ( ( first - segment.firstColumn ) > ( segment.numColumns - count ) ) )
+	{
+		std::ostringstream out;
+		out << "Columns " << first << " to " << ( static_cast < std::size_t > ( first ) + count ) << " of row " << i << " are not in the grid";
+		throw std::out_of_range ( out.str() );
+	}
+
+	const std::size_t offset = ( static_cast < std::size_t > ( i % _rowsPerSegment ) * segment.numColumns ) + ( first - segment.firstColumn );
+	return segment.heights.subspan ( offset, count );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Copy the heights starting at the 1D index into the given memory. This
+//	can cross from one segment to the next.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void HeightGrid::copy ( Index start, std::size_t size, std::uint8_t *heights ) const
+{
+	if ( ( start > this->getNumCells() ) || ( size > ( this->getNumCells() - start ) ) )
+	{
+		std::ostringstream out;
+		out << "Copying " << size << " heights from index " << start << " is out of range for " << this->getNumCells() << " heights";
+		throw std::out_of_range ( out.str() );
+	}
+
+	for ( const auto &segment : _segments )
+	{
+		if ( segment.numColumns != _numX )
+		{
+			throw std::out_of_range ( "Can not copy from a grid that does not have whole rows" );
+		}
+	}
+
+	const Index segmentSize = static_cast < Index > ( _rowsPerSegment ) * _numX;
+	while ( size > 0 )
+	{
+		const HeightsView &segment = _segments[static_cast < std::size_t > ( start / segmentSize )].heights;
+		const std::size_t offset = static_cast < std::size_t > ( start % segmentSize );
+		const std::size_t count = std::min ( size, segment.size() - offset );
+
+		std::copy_n ( segment.data() + offset, count, heights );
+
+		start += count;
+		heights += count;
+		size -= count;
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Open the input file and make sure it is big enough.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::ifstream HeightGrid::open ( unsigned int numX, unsigned int numY, const std::string &input )
+{
+	// Open the input file in binary.
+	std::ifstream in ( input.c_str(), std::ios::binary );
+
+	// Did it open?
+	if ( !in.is_open() )
+	{
+		std::ostringstream out;
+		out << "Could not open input file: " << input;
+		throw std::runtime_error ( out.str() );
+	}
+
+	// Get the size of the file and go back to the start.
+	in.seekg ( 0, std::ios::end );
+	const std::streamoff fileSize = in.tellg();
+	in.seekg ( 0, std::ios::beg );
+
+	// Make sure it has all the heights.
+	const std::size_t dataSize = static_cast < std::size_t > ( numX ) * numY * ( sizeof ( Heights::value_type ) );
+	if ( ( fileSize < 0 ) || ( static_cast < std::size_t > ( fileSize ) < dataSize ) )
+	{
+		std::ostringstream out;
+		out << "Input file " << input << " has " << fileSize << " bytes but expected " << dataSize;
+		throw std::runtime_error ( out.str() );
+	}
+
+	// Return the open file.
+	return in;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Read the heights from a raw file, one segment at a time.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid HeightGrid::read ( unsigned int numX, unsigned int numY, const std::string &input )
+{
+	// Open the input file. This also makes sure it is big enough.
+	std::ifstream in = HeightGrid::open ( numX, numY, input );
+
+	HeightGrid grid ( numX, numY, HeightGrid::getRowsPerSegment ( numX, numY ) );
+
+	// The row is 64-bit so that stepping past the last one can not wrap.
+	for ( std::uint64_t row = 0; row < numY; row += grid._rowsPerSegment )
+	{
+		const std::size_t numRows = static_cast < std::size_t > ( std::min < std::uint64_t > ( grid._rowsPerSegment, numY - row ) );
+		Heights heights ( numRows * numX );
+		Bytes::read ( in, input, heights.data(), heights.size() );
+		grid.addSegment ( 0, numX, std::move ( heights ) );
+	}
+
+	return grid;
+}
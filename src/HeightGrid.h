@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A grid of heights that is stored in segments of whole rows, so that very
+//	large height maps are not one big allocation.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The class that holds the heights.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class HeightGrid
+{
+public:
+
+	typedef std::vector < std::uint8_t > Heights;
+	typedef std::span < const std::uint8_t > HeightsView;
+	typedef std::uint64_t Index;
+
+	// The most bytes in one segment that we read. Grids smaller than this
+	// are in one segment.
+	static constexpr std::size_t SEGMENT_SIZE = ( std::size_t ( 1 ) << 30 );
+
+	// Construct an empty grid.
+	HeightGrid();
+
+	// Construct from heights owned by the caller. They are not copied,
+	// so they have to outlive this object.
+	HeightGrid ( unsigned int numX, unsigned int numY, HeightsView heights );
+
+	// Construct from heights that are moved into this object.
+	HeightGrid ( unsigned int numX, unsigned int numY, Heights &&heights );
+
+	// Construct a grid with no segments yet. Add them in order with
+	// addSegment(). The lowest and highest height grow as they are added.
+	HeightGrid ( unsigned int numX, unsigned int numY, unsigned int rowsPerSegment );
+
+	// Construct a grid that only has some of the columns of each segment of
+	// rows. Add the segments in order with addSegment(). The lowest and
+	// highest height are for the whole grid, not just the parts we have.
+	HeightGrid ( unsigned int numX, unsigned int numY, unsigned int rowsPerSegment, std::uint8_t minHeight, std::uint8_t maxHeight );
+
+	// The default destructor is fine.
+	~HeightGrid() = default;
+
+	// Movable, because the buffers of the segments move with them. Not
+	// copyable, use borrow() instead.
+	HeightGrid ( const HeightGrid & ) = delete;
+	HeightGrid ( HeightGrid && ) = default;
+	HeightGrid & operator = ( const HeightGrid & ) = delete;
+	HeightGrid & operator = ( HeightGrid && ) = default;
+
+	// Make a grid that looks at our heights without copying them. It has to
+	// be gone before this object is.
+	HeightGrid borrow() const;
+
+	// Add the next segment of rows, with the heights of the given columns
+	// of each row. The number of columns can be zero.
+	void addSegment ( unsigned int firstColumn, unsigned int numColumns, Heights &&heights );
+
+	// Copy the heights starting at the 1D index into the given memory. The
+	// rows have to be whole.
+	void copy ( Index start, std::size_t size, std::uint8_t *heights ) const;
+
+	// Is it empty?
+	bool empty() const { return _segments.empty(); }
+
+	// Get the size.
+	unsigned int getNumX() const { return _numX; }
+	unsigned int getNumY() const { return _numY; }
+	Index getNumCells() const { return ( static_cast < Index > ( _numX ) * _numY ); }
+
+	// Get the number of rows in each segment.
+	unsigned int getRowsPerSegment() const { return _rowsPerSegment; }
+
+	// Get the number of rows in each segment that keeps a segment of whole
+	// rows under SEGMENT_SIZE bytes, but at least one row.
+	static unsigned int getRowsPerSegment ( unsigned int numX, unsigned int numY );
+
+	// Get the bytes of heights this grid owns.
+	std::size_t getOwnedBytes() const;
+
+	// Get the row of heights. The whole row has to be in the grid.
+	HeightsView getRow ( unsigned int i ) const;
+
+	// Get the given columns of the row of heights.
+	HeightsView getRow ( unsigned int i, unsigned int first, unsigned int count ) const;
+
+	// Get the lowest and highest height. They are found once when the
+	// heights are given or read, so asking is cheap. With no heights the
+	// lowest is above the highest.
+	std::uint8_t getMinHeight() const { return _minHeight; }
+	std::uint8_t getMaxHeight() const { return _maxHeight; }
+
+	// Open the raw file of heights and make sure it is big enough.
+	static std::ifstream open ( unsigned int numX, unsigned int numY, const std::string &input );
+
+	// Read the heights from a raw file, one segment at a time.
+	static HeightGrid read ( unsigned int numX, unsigned int numY, const std::string &input );
+
+protected:
+
+	void _addHeightRange ( HeightsView heights );
+	void _checkSize ( std::size_t size ) const;
+
+private:
+
+	// The heights of some whole rows, and the columns of them we have.
+	struct Segment
+	{
+		HeightsView heights;
+		unsigned int firstColumn = 0;
+		unsigned int numColumns = 0;
+	};
+
+	unsigned int _numX;
+	unsigned int _numY;
+	unsigned int _rowsPerSegment;
+	std::uint8_t _minHeight;
+	std::uint8_t _maxHeight;
+	std::vector < Heights > _owned;
+	std::vector < Segment > _segments;
+};
@@ -0,0 +1,398 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A file with the heights that changed from a base height map.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HeightMapDelta.h"
+#include "Bytes.h"
+#include "Hasher.h"
+#include "HeightMapFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Helper functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+	const char MAGIC[4] = { 'P', 'D', 'H', 'D' };
+	const std::uint32_t VERSION = 1;
+
+	// The size of the header and of the start of a run.
+	const std::size_t HEADER_SIZE = 48;
+	const std::size_t RUN_SIZE = 12;
+
+	// Runs that are closer than this are joined.
+	const std::size_t MIN_GAP = RUN_SIZE;
+
+	// The number of cells handled at once when applying the changes.
+	const std::size_t CHUNK_SIZE = 1 << 20;
+} }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightMapDelta::HeightMapDelta ( const std::string &file ) :
+	_file ( file ),
+	_in ( file.c_str(), std::ios::binary ),
+	_header(),
+	_applied ( false )
+{
+	// Did it open?
+	if ( !_in.is_open() )
+	{
+		std::ostringstream out;
+		out << "Could not open input file: " << file;
+		throw std::runtime_error ( out.str() );
+	}
+
+	// Read the header.
+	Bytes::Buffer bytes ( Details::HEADER_SIZE );
+	Bytes::read ( _in, _file, bytes );
+
+	if ( 0 != std::memcmp ( bytes.data(), Details::MAGIC, 4 ) )
+	{
+		throw std::runtime_error ( "Not a height map delta file: " + file );
+	}
+
+	std::size_t pos = 4;
+	const std::uint32_t version = Bytes::get32 ( bytes, pos );
+	if ( Details::VERSION != version )
+	{
+		std::ostringstream out;
+		out << "Height map delta file " << file << " has version " << version << " but expected " << Details::VERSION;
+		throw std::runtime_error ( out.str() );
+	}
+
+	_header.numX = Bytes::get32 ( bytes, pos );
+	_header.numY = Bytes::get32 ( bytes, pos );
+	_header.baseHash = Bytes::get64 ( bytes, pos );
+	_header.afterHash = Bytes::get64 ( bytes, pos );
+	_header.numRuns = Bytes::get64 ( bytes, pos );
+	_header.numChanged = Bytes::get64 ( bytes, pos );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Is the file one of ours?
+//
+////////////////////////////////////////////////////////////////////////////////
+
+bool HeightMapDelta::isDeltaFile ( const std::string &file )
+{
+	std::ifstream in ( file.c_str(), std::ios::binary );
+	char magic[4] = { 0, 0, 0, 0 };
+	in.read ( magic, 4 );
+	return ( ( 4 == in.gcount() ) && ( 0 == std::memcmp ( magic, Details::MAGIC, 4 ) ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the heights after the changes, one segment of rows at a time. The
+//	base heights are copied into the segment one chunk at a time. Each chunk
+//	is hashed, then the runs that land in it are read straight into place,
+//	then it is hashed again. So the base and the runs are each read once,
+//	and both hashes are checked.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+template < class ReadBase > HeightGrid HeightMapDelta::_apply ( ReadBase readBase )
+{
+	if ( _applied )
+	{
+		throw std::runtime_error ( "Height map delta file has already been applied: " + _file );
+	}
+	_applied = true;
+
+	const std::size_t numCells = static_cast < std::size_t > ( _header.numX ) * _header.numY;
+	HeightGrid after ( _header.numX, _header.numY, HeightGrid::getRowsPerSegment ( _header.numX, _header.numY ) );
+	const std::size_t segmentSize = static_cast < std::size_t > ( after.getRowsPerSegment() ) * _header.numX;
+
+	Hasher baseHash;
+	Hasher afterHash;
+
+	// The run we are in, and how much of it is done.
+	std::uint64_t runsLeft = _header.numRuns;
+	std::uint64_t runStart = 0;
+	std::uint64_t runSize = 0;
+	std::uint64_t runDone = 0;
+	std::uint64_t numChanged = 0;
+	Bytes::Buffer runBytes ( Details::RUN_SIZE );
+
+	// Read the start of the next run, if there is one.
+	auto nextRun = [&]()
+	{
+		if ( 0 == runsLeft )
+		{
+			runSize = 0;
+			return false;
+		}
+		--runsLeft;
+
+		const std::uint64_t end = runStart + runSize;
+		Bytes::read ( _in, _file, runBytes );
+		std::size_t pos = 0;
+		runStart = Bytes::get64 ( runBytes, pos );
+		runSize = Bytes::get32 ( runBytes, pos );
+		runDone = 0;
+
+		if ( ( 0 == runSize ) || ( runStart < end ) || ( ( runStart + runSize ) > numCells ) )
+		{
+			throw std::runtime_error ( "Invalid run of changes in height map delta file: " + _file );
+		}
+		return true;
+	};
+	bool haveRun = nextRun();
+
+	for ( std::size_t first = 0; first < numCells; first += segmentSize )
+	{
+		const std::size_t last = std::min ( first + segmentSize, numCells );
+		Heights heights ( last - first );
+
+		for ( std::size_t offset = first; offset < last; offset += Details::CHUNK_SIZE )
+		{
+			const std::size_t size = std::min ( Details::CHUNK_SIZE, last - offset );
+			unsigned char *chunk = heights.data() + ( offset - first );
+
+			// Get the base heights for this chunk.
+			readBase ( chunk, offset, size );
+			baseHash.update ( chunk, size );
+
+			// Put the runs that land in this chunk on top.
+			while ( haveRun && ( runStart + runDone ) < ( offset + size ) )
+			{
+				const std::uint64_t pos = runStart + runDone;
+				const std::uint64_t count = std::min < std::uint64_t > ( runSize - runDone, ( offset + size ) - pos );
+				Bytes::read ( _in, _file, heights.data() + ( pos - first ), static_cast < std::size_t > ( count ) );
+				runDone += count;
+				numChanged += count;
+
+				if ( runDone < runSize )
+				{
+					break;
+				}
+				haveRun = nextRun();
+			}
+
+			afterHash.update ( chunk, size );
+		}
+
+		after.addSegment ( 0, _header.numX, std::move ( heights ) );
+	}
+
+	// Make sure it all worked.
+	if ( haveRun || ( numChanged != _header.numChanged ) )
+	{
+		throw std::runtime_error ( "Runs of changes do not match the header in height map delta file: " + _file );
+	}
+	if ( baseHash.getValue() != _header.baseHash )
+	{
+		throw std::runtime_error ( "Base heights are not the ones height map delta file " + _file + " was made from" );
+	}
+	if ( afterHash.getValue() != _header.afterHash )
+	{
+		throw std::runtime_error ( "Heights after applying height map delta file " + _file + " do not match its hash" );
+	}
+
+	return after;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the heights after the changes from the base heights in memory.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid HeightMapDelta::apply ( HeightsView base )
+{
+	const std::size_t numCells = static_cast < std::size_t > ( _header.numX ) * _header.numY;
+	if ( base.size() != numCells )
+	{
+		std::ostringstream out;
+		out << "Given " << base.size() << " base heights but height map delta file " << _file << " has " << numCells;
+		throw std::invalid_argument ( out.str() );
+	}
+
+	// Copy straight from the view. Wrapping it in a grid would look at all
+	// the heights to find their range, which we do not need.
+	return this->_apply ( [&] ( unsigned char *chunk, std::size_t offset, std::size_t size )
+	{
+		std::copy_n ( base.data() + offset, size, chunk );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the heights after the changes from the grid of base heights.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid HeightMapDelta::apply ( const HeightGrid &base )
+{
+	if ( ( base.getNumX() != _header.numX ) || ( base.getNumY() != _header.numY ) )
+	{
+		std::ostringstream out;
+		out << "Given " << base.getNumX() << " by " << base.getNumY() << " base heights but height map delta file " << _file << " is " << _header.numX << " by " << _header.numY;
+		throw std::invalid_argument ( out.str() );
+	}
+
+	return this->_apply ( [&] ( unsigned char *chunk, std::size_t offset, std::size_t size )
+	{
+		base.copy ( offset, size, chunk );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the heights after the changes from the base file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid HeightMapDelta::apply ( const std::string &baseFile )
+{
+	// Tiled files have to be put together first.
+	if ( HeightMapFile::isHeightMapFile ( baseFile ) )
+	{
+		HeightMapFile file ( baseFile );
+		return this->apply ( file.readAll() );
+	}
+
+	// Raw files are read a chunk at a time.
+	std::ifstream in = HeightGrid::open ( _header.numX, _header.numY, baseFile );
+	return this->_apply ( [&] ( unsigned char *chunk, std::size_t, std::size_t size )
+	{
+		Bytes::read ( in, baseFile, chunk, size );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Write the changes to a new file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightMapDelta::Header HeightMapDelta::write ( const std::string &file, const HeightGrid &base, const HeightGrid &after )
+{
+	const unsigned int numX = base.getNumX();
+	const unsigned int numY = base.getNumY();
+	if ( ( after.getNumX() != numX ) || ( after.getNumY() != numY ) )
+	{
+		std::ostringstream out;
+		out << "Given " << numX << " by " << numY << " base heights and " << after.getNumX() << " by " << after.getNumY() << " after heights";
+		throw std::invalid_argument ( out.str() );
+	}
+
+	// Find the runs of changes and hash both, one row at a time. A change
+	// joins the run before it when the gap is small enough, so runs can go
+	// from one row to the next.
+	const std::size_t maxRun = std::numeric_limits < std::uint32_t >::max();
+	std::vector < std::pair < std::size_t, std::size_t > > runs;
+	std::uint64_t numChanged = 0;
+	Hasher baseHash;
+	Hasher afterHash;
+	for ( unsigned int i = 0; i < numY; ++i )
+	{
+		const HeightsView baseRow = base.getRow ( i );
+		const HeightsView afterRow = after.getRow ( i );
+		baseHash.update ( baseRow.data(), baseRow.size() );
+		afterHash.update ( afterRow.data(), afterRow.size() );
+
+		const std::size_t rowStart = static_cast < std::size_t > ( i ) * numX;
+		for ( std::size_t j = 0; j < numX; ++j )
+		{
+			if ( baseRow[j] == afterRow[j] )
+			{
+				continue;
+			}
+
+			const std::size_t k = rowStart + j;
+			if ( !runs.empty() )
+			{
+				auto &run = runs.back();
+				const std::size_t end = run.first + run.second;
+				if ( ( ( k - end ) < Details::MIN_GAP ) && ( ( k - run.first ) < maxRun ) )
+				{
+					numChanged += ( k + 1 - end );
+					run.second = ( k + 1 - run.first );
+					continue;
+				}
+			}
+
+			runs.push_back ( std::make_pair ( k, 1 ) );
+			++numChanged;
+		}
+	}
+
+	Header header;
+	header.numX = numX;
+	header.numY = numY;
+	header.numRuns = runs.size();
+	header.numChanged = numChanged;
+	header.baseHash = baseHash.getValue();
+	header.afterHash = afterHash.getValue();
+
+	// Write it all.
+	std::ofstream out ( file.c_str(), std::ios::binary | std::ios::trunc );
+	if ( !out.is_open() )
+	{
+		throw std::runtime_error ( "Could not open output file: " + file );
+	}
+
+	Bytes::Buffer bytes;
+	bytes.insert ( bytes.end(), Details::MAGIC, Details::MAGIC + 4 );
+	Bytes::put32 ( bytes, Details::VERSION );
+	Bytes::put32 ( bytes, header.numX );
+	Bytes::put32 ( bytes, header.numY );
+	Bytes::put64 ( bytes, header.baseHash );
+	Bytes::put64 ( bytes, header.afterHash );
+	Bytes::put64 ( bytes, header.numRuns );
+	Bytes::put64 ( bytes, header.numChanged );
+	out.write ( reinterpret_cast < const char * > ( bytes.data() ), bytes.size() );
+
+	for ( const auto &run : runs )
+	{
+		bytes.clear();
+		Bytes::put64 ( bytes, run.first );
+		Bytes::put32 ( bytes, static_cast < std::uint32_t > ( run.second ) );
+		out.write ( reinterpret_cast < const char * > ( bytes.data() ), bytes.size() );
+
+		// The run can cross rows.
+		for ( std::size_t k = run.first; k < ( run.first + run.second ); )
+		{
+			const unsigned int i = static_cast < unsigned int > ( k / numX );
+			const unsigned int j = static_cast < unsigned int > ( k % numX );
+			const std::size_t count = std::min < std::size_t > ( ( run.first + run.second ) - k, numX - j );
+			const HeightsView part = after.getRow ( i, j, static_cast < unsigned int > ( count ) );
+			out.write ( reinterpret_cast < const char * > ( part.data() ), part.size() );
+			k += count;
+		}
+	}
+
+	if ( !out.good() )
+	{
+		throw std::runtime_error ( "Could not write output file: " + file );
+	}
+
+	return header;
+}
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A file with the heights that changed from a base height map, stored as
+//	runs of changed cells.
+//
+//	All numbers are little-endian. The file is:
+//
+//	  Header   "PDHD", version, numX, numY, hash of the base heights, hash
+//	           of the heights after the changes, number of runs, and the
+//	           number of cells in all the runs.
+//	  Runs     For each run in order: the index of its first cell, the
+//	           number of cells, and then the new heights of those cells.
+//
+//	Runs of changes that are only a few cells apart are joined, because a
+//	few unchanged cells take less room than the start of another run.
+//	The hashes are from Hasher, so the hash of the heights after the
+//	changes is the same as the hash of the raw file of those heights.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "HeightGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The class that reads and writes the file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class HeightMapDelta
+{
+public:
+
+	typedef HeightGrid::Heights Heights;
+	typedef HeightGrid::HeightsView HeightsView;
+
+	// What the header says.
+	struct Header
+	{
+		unsigned int numX = 0;
+		unsigned int numY = 0;
+		std::uint64_t baseHash = 0;
+		std::uint64_t afterHash = 0;
+		std::uint64_t numRuns = 0;
+		std::uint64_t numChanged = 0;
+	};
+
+	// Open the file and read the header.
+	explicit HeightMapDelta ( const std::string &file );
+
+	// The default destructor is fine.
+	~HeightMapDelta() = default;
+
+	// Not copyable or movable.
+	HeightMapDelta ( const HeightMapDelta & ) = delete;
+	HeightMapDelta ( HeightMapDelta && ) = delete;
+	HeightMapDelta & operator = ( const HeightMapDelta & ) = delete;
+	HeightMapDelta & operator = ( HeightMapDelta && ) = delete;
+
+	// Is the file one of ours? Only looks at the first few bytes.
+	static bool isDeltaFile ( const std::string &file );
+
+	// Get the header.
+	const Header &getHeader() const { return _header; }
+
+	// Make the heights after the changes from the base heights in memory.
+	// This can only be done once for each object. The answer is made one
+	// segment of rows at a time, so it is never one big allocation.
+	HeightGrid apply ( HeightsView base );
+	HeightGrid apply ( const HeightGrid &base );
+
+	// Make the heights after the changes from the base file, which is
+	// either raw heights or a HeightMapFile. The raw file is read in the
+	// same pass that applies the changes.
+	HeightGrid apply ( const std::string &baseFile );
+
+	// Write the changes from the base to the after heights to a new file.
+	// Both grids have to have whole rows.
+	static Header write ( const std::string &file, const HeightGrid &base, const HeightGrid &after );
+
+protected:
+
+	template < class ReadBase > HeightGrid _apply ( ReadBase readBase );
+
+private:
+
+	std::string _file;
+	std::ifstream _in;
+	Header _header;
+	bool _applied;
+};
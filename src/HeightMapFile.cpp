@@ -0,0 +1,467 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A self-describing file of heights, stored in square tiles.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HeightMapFile.h"
+#include "Bytes.h"
+#include "Tools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Helper functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+	const char MAGIC[4] = { 'P', 'D', 'H', 'M' };
+	const std::uint32_t VERSION = 1;
+
+	// The size of the header without and with the checksum, and of a tile
+	// in the index.
+	const std::size_t HEADER_SIZE = 56;
+	const std::size_t HEADER_SIZE_WITH_CHECKSUM = HEADER_SIZE + 8;
+	const std::size_t TILE_SIZE = 24;
+
+	// Make the bytes of the header without the checksum.
+	inline Bytes::Buffer makeHeader ( const HeightMapFile::Header &header )
+	{
+		Bytes::Buffer bytes;
+		bytes.insert ( bytes.end(), MAGIC, MAGIC + 4 );
+		Bytes::put32 ( bytes, VERSION );
+		Bytes::put32 ( bytes, header.numX );
+		Bytes::put32 ( bytes, header.numY );
+		Bytes::put32 ( bytes, header.sampleType );
+		Bytes::put32 ( bytes, header.tileSize );
+		Bytes::putDouble ( bytes, header.horizontalResolution );
+		Bytes::putDouble ( bytes, header.verticalResolution );
+		Bytes::putDouble ( bytes, header.minHeight );
+		Bytes::putDouble ( bytes, header.maxHeight );
+		return bytes;
+	}
+
+	// Get the number of tiles needed to cover the cells.
+	inline unsigned int numTiles ( unsigned int numCells, unsigned int tileSize )
+	{
+		return ( ( numCells + tileSize - 1 ) / tileSize );
+	}
+} }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightMapFile::HeightMapFile ( const std::string &file ) :
+	_file ( file ),
+	_in ( file.c_str(), std::ios::binary ),
+	_header(),
+	_checksum ( 0 ),
+	_numTilesX ( 0 ),
+	_numTilesY ( 0 ),
+	_tiles()
+{
+	// Did it open?
+	if ( !_in.is_open() )
+	{
+		std::ostringstream out;
+		out << "Could not open input file: " << file;
+		throw std::runtime_error ( out.str() );
+	}
+
+	// Read the header.
+	Bytes::Buffer bytes ( Details::HEADER_SIZE_WITH_CHECKSUM );
+	Bytes::read ( _in, _file, bytes );
+
+	if ( 0 != std::memcmp ( bytes.data(), Details::MAGIC, 4 ) )
+	{
+		throw std::runtime_error ( "Not a height map file: " + file );
+	}
+
+	std::size_t pos = 4;
+	const std::uint32_t version = Bytes::get32 ( bytes, pos );
+	if ( Details::VERSION != version )
+	{
+		std::ostringstream out;
+		out << "Height map file " << file << " has version " << version << " but expected " << Details::VERSION;
+		throw std::runtime_error ( out.str() );
+	}
+
+	_header.numX = Bytes::get32 ( bytes, pos );
+	_header.numY = Bytes::get32 ( bytes, pos );
+	_header.sampleType = Bytes::get32 ( bytes, pos );
+	_header.tileSize = Bytes::get32 ( bytes, pos );
+	_header.horizontalResolution = Bytes::getDouble ( bytes, pos );
+	_header.verticalResolution = Bytes::getDouble ( bytes, pos );
+	_header.minHeight = Bytes::getDouble ( bytes, pos );
+	_header.maxHeight = Bytes::getDouble ( bytes, pos );
+	_checksum = Bytes::get64 ( bytes, pos );
+
+	if ( SAMPLE_UINT8 != _header.sampleType )
+	{
+		std::ostringstream out;
+		out << "Height map file " << file << " has unsupported sample type " << _header.sampleType;
+		throw std::runtime_error ( out.str() );
+	}
+
+	if ( ( 0 == _header.numX ) || ( 0 == _header.numY ) || ( 0 == _header.tileSize ) )
+	{
+		throw std::runtime_error ( "Height map file " + file + " has a size of zero" );
+	}
+
+	// Read the tile index.
+	_numTilesX = Details::numTiles ( _header.numX, _header.tileSize );
+	_numTilesY = Details::numTiles ( _header.numY, _header.tileSize );
+	Bytes::Buffer index ( static_cast < std::size_t > ( _numTilesX ) * _numTilesY * Details::TILE_SIZE );
+	Bytes::read ( _in, _file, index );
+
+	// The checksum covers the header and the index.
+	const std::uint64_t expected = Tools::hash ( index.data(), index.size(), Tools::hash ( bytes.data(), Details::HEADER_SIZE ) );
+	if ( expected != _checksum )
+	{
+		throw std::runtime_error ( "Header checksum does not match in height map file: " + file );
+	}
+
+	pos = 0;
+	_tiles.resize ( static_cast < std::size_t > ( _numTilesX ) * _numTilesY );
+	for ( auto &tile : _tiles )
+	{
+		tile.offset = Bytes::get64 ( index, pos );
+		tile.size = Bytes::get64 ( index, pos );
+		tile.checksum = Bytes::get64 ( index, pos );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Is the file one of ours?
+//
+////////////////////////////////////////////////////////////////////////////////
+
+bool HeightMapFile::isHeightMapFile ( const std::string &file )
+{
+	std::ifstream in ( file.c_str(), std::ios::binary );
+	char magic[4] = { 0, 0, 0, 0 };
+	in.read ( magic, 4 );
+	return ( ( 4 == in.gcount() ) && ( 0 == std::memcmp ( magic, Details::MAGIC, 4 ) ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Read all the heights, one row of tiles at a time.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid HeightMapFile::readAll()
+{
+	HeightGrid grid ( _header.numX, _header.numY, _header.tileSize );
+
+	for ( unsigned int ty = 0; ty < _numTilesY; ++ty )
+	{
+		this->_addTiles ( 0, _numTilesX - 1, ty, grid );
+	}
+
+	return grid;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Read the tiles from first to last in the row of tiles, and add them to
+//	the grid as the next segment.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void HeightMapFile::_addTiles ( unsigned int firstTileX, unsigned int lastTileX, unsigned int tileY, HeightGrid &grid )
+{
+	// The cells these tiles cover.
+	const std::size_t col = static_cast < std::size_t > ( firstTileX ) * _header.tileSize;
+	const std::size_t row = static_cast < std::size_t > ( tileY ) * _header.tileSize;
+	const std::size_t width = std::min < std::size_t > ( static_cast < std::size_t > ( lastTileX + 1 ) * _header.tileSize, _header.numX ) - col;
+	const std::size_t height = std::min < std::size_t > ( _header.tileSize, _header.numY - row );
+
+	Heights heights ( width * height );
+	for ( unsigned int tx = firstTileX; tx <= lastTileX; ++tx )
+	{
+		const std::size_t offset = ( static_cast < std::size_t > ( tx ) * _header.tileSize ) - col;
+		this->_readTile ( tx, tileY, heights.data() + offset, width );
+	}
+
+	grid.addSegment ( static_cast < unsigned int > ( col ), static_cast < unsigned int > ( width ), std::move ( heights ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Read one tile. Its first cell goes at the corner, and each row of it
+//	goes the given number of cells after the one before.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void HeightMapFile::_readTile ( unsigned int tileX, unsigned int tileY, std::uint8_t *corner, std::size_t rowSize )
+{
+	const std::size_t numX = _header.numX;
+	const std::size_t numY = _header.numY;
+
+	if ( ( tileX >= _numTilesX ) || ( tileY >= _numTilesY ) )
+	{
+		std::ostringstream out;
+		out << "Tile [" << tileX << "," << tileY << "] is out of range for " << _numTilesX << " by " << _numTilesY << " tiles";
+		throw std::out_of_range ( out.str() );
+	}
+
+	// The cells this tile covers.
+	const std::size_t col = static_cast < std::size_t > ( tileX ) * _header.tileSize;
+	const std::size_t row = static_cast < std::size_t > ( tileY ) * _header.tileSize;
+	const std::size_t width = std::min < std::size_t > ( _header.tileSize, numX - col );
+	const std::size_t height = std::min < std::size_t > ( _header.tileSize, numY - row );
+
+	// Go straight to the tile and read it.
+	const Tile &tile = _tiles.at ( static_cast < std::size_t > ( tileY ) * _numTilesX + tileX );
+	if ( tile.size != ( width * height ) )
+	{
+		std::ostringstream out;
+		out << "Tile [" << tileX << "," << tileY << "] has " << tile.size << " bytes but expected " << ( width * height );
+		throw std::runtime_error ( out.str() );
+	}
+
+	Bytes::Buffer bytes ( tile.size );
+	_in.clear();
+	_in.seekg ( static_cast < std::streamoff > ( tile.offset ), std::ios::beg );
+	Bytes::read ( _in, _file, bytes );
+
+	if ( tile.checksum != Tools::hash ( bytes.data(), bytes.size() ) )
+	{
+		std::ostringstream out;
+		out << "Checksum does not match for tile [" << tileX << "," << tileY << "] in height map file: " << _file;
+		throw std::runtime_error ( out.str() );
+	}
+
+	// Copy the rows of the tile into place.
+	for ( std::size_t i = 0; i < height; ++i )
+	{
+		std::copy_n ( bytes.data() + ( i * width ), width, corner + ( i * rowSize ) );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Read only the tiles near the path. In each row of tiles the ones near
+//	the path are next to each other, because the path grown by the margin
+//	is convex, so one span of columns holds them.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+HeightGrid HeightMapFile::readNearPath ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double margin )
+{
+	// The first and last tile in each row of tiles.
+	std::vector < std::pair < unsigned int, unsigned int > > spans ( _numTilesY, std::make_pair ( _numTilesX, 0u ) );
+	for ( const auto &tile : this->getTilesNearPath ( i1, j1, i2, j2, margin ) )
+	{
+		auto &span = spans[tile.second];
+		span.first = std::min ( span.first, tile.first );
+		span.second = std::max ( span.second, tile.first );
+	}
+
+	// The heights can be anywhere in the range of the whole file.
+	const std::uint8_t minHeight = static_cast < std::uint8_t > ( _header.minHeight );
+	const std::uint8_t maxHeight = static_cast < std::uint8_t > ( _header.maxHeight );
+	HeightGrid grid ( _header.numX, _header.numY, _header.tileSize, minHeight, maxHeight );
+
+	for ( unsigned int ty = 0; ty < _numTilesY; ++ty )
+	{
+		const auto &span = spans[ty];
+		if ( span.first > span.second )
+		{
+			grid.addSegment ( 0, 0, Heights() );
+		}
+		else
+		{
+			this->_addTiles ( span.first, span.second, ty, grid );
+		}
+	}
+
+	return grid;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the tiles that are near the path. A tile is near when the path
+//	crosses its cells grown by the margin on every side. This is the slab
+//	test for a line segment and a box.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::vector < std::pair < unsigned int, unsigned int > > HeightMapFile::getTilesNearPath ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double margin ) const
+{
+	std::vector < std::pair < unsigned int, unsigned int > > answer;
+
+	// The path in cell coordinates, with x along the columns.
+	const double x1 = j1, y1 = i1;
+	const double dx = static_cast < double > ( j2 ) - x1;
+	const double dy = static_cast < double > ( i2 ) - y1;
+	const double size = _header.tileSize;
+
+	for ( unsigned int ty = 0; ty < _numTilesY; ++ty )
+	{
+		for ( unsigned int tx = 0; tx < _numTilesX; ++tx )
+		{
+			// The cells of the tile, grown by the margin. The last cell of a
+			// tile shares its far edge with the first cell of the next one.
+			const double minX = ( tx * size ) - margin;
+			const double maxX = ( ( tx + 1 ) * size ) + margin;
+			const double minY = ( ty * size ) - margin;
+			const double maxY = ( ( ty + 1 ) * size ) + margin;
+
+			// Clip the segment's parameter range against each slab.
+			double t0 = 0, t1 = 1;
+			bool hit = true;
+			const double starts[2] = { x1, y1 };
+			const double deltas[2] = { dx, dy };
+			const double mins[2] = { minX, minY };
+			const double maxs[2] = { maxX, maxY };
+			for ( unsigned int k = 0; ( k < 2 ) && hit; ++k )
+			{
+				if ( 0 == deltas[k] )
+				{
+					hit = ( ( starts[k] >= mins[k] ) && ( starts[k] <= maxs[k] ) );
+					continue;
+				}
+				double a = ( mins[k] - starts[k] ) / deltas[k];
+				double b = ( maxs[k] - starts[k] ) / deltas[k];
+				if ( a > b )
+				{
+					std::swap ( a, b );
+				}
+				t0 = std::max ( t0, a );
+				t1 = std::min ( t1, b );
+				hit = ( t0 <= t1 );
+			}
+
+			if ( hit )
+			{
+				answer.push_back ( std::make_pair ( tx, ty ) );
+			}
+		}
+	}
+
+	return answer;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Write the heights to a new file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void HeightMapFile::write ( const std::string &file, const Header &given, const HeightGrid &heights )
+{
+	const std::size_t numX = given.numX;
+	const std::size_t numY = given.numY;
+
+	if ( ( 0 == numX ) || ( 0 == numY ) || ( 0 == given.tileSize ) )
+	{
+		throw std::invalid_argument ( "Height map size and tile size must be greater than zero" );
+	}
+
+	if ( SAMPLE_UINT8 != given.sampleType )
+	{
+		std::ostringstream out;
+		out << "Unsupported sample type " << given.sampleType;
+		throw std::invalid_argument ( out.str() );
+	}
+
+	if ( !( given.horizontalResolution > 0 ) || !( given.verticalResolution > 0 ) )
+	{
+		throw std::invalid_argument ( "Height map resolution must be greater than zero" );
+	}
+
+	if ( ( heights.getNumX() != numX ) || ( heights.getNumY() != numY ) )
+	{
+		std::ostringstream out;
+		out << "Given " << heights.getNumX() << " by " << heights.getNumY() << " heights but expected " << numX << " by " << numY;
+		throw std::invalid_argument ( out.str() );
+	}
+
+	// The range of the heights goes in the header.
+	Header header = given;
+	header.minHeight = heights.getMinHeight();
+	header.maxHeight = heights.getMaxHeight();
+
+	const unsigned int numTilesX = Details::numTiles ( header.numX, header.tileSize );
+	const unsigned int numTilesY = Details::numTiles ( header.numY, header.tileSize );
+
+	// Open the file.
+	std::ofstream out ( file.c_str(), std::ios::binary | std::ios::trunc );
+	if ( !out.is_open() )
+	{
+		throw std::runtime_error ( "Could not open output file: " + file );
+	}
+
+	// Leave room for the header and index. We come back to them after the
+	// tiles, when we know their checksums.
+	const std::uint64_t headerAndIndexSize = Details::HEADER_SIZE_WITH_CHECKSUM + ( static_cast < std::uint64_t > ( numTilesX ) * numTilesY * Details::TILE_SIZE );
+	const Bytes::Buffer placeholder ( headerAndIndexSize, 0 );
+	out.write ( reinterpret_cast < const char * > ( placeholder.data() ), placeholder.size() );
+
+	// Write the tiles one at a time.
+	Bytes::Buffer indexBytes;
+	std::uint64_t offset = headerAndIndexSize;
+	Bytes::Buffer bytes;
+	for ( unsigned int ty = 0; ty < numTilesY; ++ty )
+	{
+		for ( unsigned int tx = 0; tx < numTilesX; ++tx )
+		{
+			const std::size_t col = static_cast < std::size_t > ( tx ) * header.tileSize;
+			const std::size_t row = static_cast < std::size_t > ( ty ) * header.tileSize;
+			const std::size_t width = std::min < std::size_t > ( header.tileSize, numX - col );
+			const std::size_t height = std::min < std::size_t > ( header.tileSize, numY - row );
+
+			bytes.clear();
+			for ( std::size_t i = 0; i < height; ++i )
+			{
+				const HeightsView part = heights.getRow ( static_cast < unsigned int > ( row + i ), static_cast < unsigned int > ( col ), static_cast < unsigned int > ( width ) );
+				bytes.insert ( bytes.end(), part.begin(), part.end() );
+			}
+
+			out.write ( reinterpret_cast < const char * > ( bytes.data() ), bytes.size() );
+
+			Bytes::put64 ( indexBytes, offset );
+			Bytes::put64 ( indexBytes, bytes.size() );
+			Bytes::put64 ( indexBytes, Tools::hash ( bytes.data(), bytes.size() ) );
+			offset += bytes.size();
+		}
+	}
+
+	// Make the header, and the checksum of it and the index.
+	Bytes::Buffer headerBytes = Details::makeHeader ( header );
+	const std::uint64_t checksum = Tools::hash ( indexBytes.data(), indexBytes.size(), Tools::hash ( headerBytes.data(), headerBytes.size() ) );
+	Bytes::put64 ( headerBytes, checksum );
+
+	// Go back and write them.
+	out.seekp ( 0, std::ios::beg );
+	out.write ( reinterpret_cast < const char * > ( headerBytes.data() ), headerBytes.size() );
+	out.write ( reinterpret_cast < const char * > ( indexBytes.data() ), indexBytes.size() );
+
+	if ( !out.good() )
+	{
+		throw std::runtime_error ( "Could not write output file: " + file );
+	}
+}
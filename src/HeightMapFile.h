@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A self-describing file of heights, stored in square tiles.
+//
+//	All numbers are little-endian. The file is:
+//
+//	  Header   "PDHM", version, numX, numY, sample type, tile size,
+//	           horizontal and vertical resolution in meters, smallest and
+//	           largest height sample, then a checksum of the header and
+//	           the tile index.
+//	  Index    For each tile in row order: offset, size, and checksum of
+//	           its data.
+//	  Tiles    The samples of each tile, one row of the tile at a time.
+//
+//	The tiles on the right and bottom edges are smaller when the size of
+//	the grid is not a multiple of the tile size.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Constants.h"
+#include "HeightGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The class that reads and writes the file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class HeightMapFile
+{
+public:
+
+	typedef HeightGrid::Heights Heights;
+	typedef HeightGrid::HeightsView HeightsView;
+
+	// The types of samples. Only one is supported so far.
+	enum SampleType
+	{
+		SAMPLE_UINT8 = 1
+	};
+
+	// What the header says.
+	struct Header
+	{
+		unsigned int numX = 0;
+		unsigned int numY = 0;
+		unsigned int sampleType = SAMPLE_UINT8;
+		unsigned int tileSize = 256;
+		double horizontalResolution = Constants::DEFAULT_HORIZONTAL_RESOLUTION;
+		double verticalResolution = Constants::DEFAULT_VERTICAL_RESOLUTION;
+		double minHeight = 0;
+		double maxHeight = 0;
+	};
+
+	// Where a tile is in the file.
+	struct Tile
+	{
+		std::uint64_t offset = 0;
+		std::uint64_t size = 0;
+		std::uint64_t checksum = 0;
+	};
+
+	// Open the file and read the header and the tile index.
+	explicit HeightMapFile ( const std::string &file );
+
+	// The default destructor is fine.
+	~HeightMapFile() = default;
+
+	// Not copyable or movable.
+	HeightMapFile ( const HeightMapFile & ) = delete;
+	HeightMapFile ( HeightMapFile && ) = delete;
+	HeightMapFile & operator = ( const HeightMapFile & ) = delete;
+	HeightMapFile & operator = ( HeightMapFile && ) = delete;
+
+	// Is the file one of ours? Only looks at the first few bytes.
+	static bool isHeightMapFile ( const std::string &file );
+
+	// Get the header.
+	const Header &getHeader() const { return _header; }
+
+	// Get the checksum of the header and the tile index. Because the index
+	// has the checksum of every tile, this stands for the whole file.
+	std::uint64_t getChecksum() const { return _checksum; }
+
+	// Get the number of tiles in each direction.
+	unsigned int getNumTilesX() const { return _numTilesX; }
+	unsigned int getNumTilesY() const { return _numTilesY; }
+
+	// Read all the heights. The grid has one segment for each row of tiles.
+	HeightGrid readAll();
+
+	// Read only the tiles within the given number of cells of the path
+	// from [i1,j1] to [i2,j2]. The grid has one segment for each row of
+	// tiles, with the columns of the tiles we read. The i indices are rows.
+	HeightGrid readNearPath ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double margin );
+
+	// Get the tiles, as x and y pairs, that are within the given number of
+	// cells of the path from [i1,j1] to [i2,j2]. The i indices are rows.
+	std::vector < std::pair < unsigned int, unsigned int > > getTilesNearPath ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double margin ) const;
+
+	// Write the heights to a new file. The grid has to have whole rows.
+	static void write ( const std::string &file, const Header &header, const HeightGrid &heights );
+
+protected:
+
+	void _addTiles ( unsigned int firstTileX, unsigned int lastTileX, unsigned int tileY, HeightGrid &grid );
+	void _readTile ( unsigned int tileX, unsigned int tileY, std::uint8_t *corner, std::size_t rowSize );
+
+private:
+
+	std::string _file;
+	std::ifstream _in;
+	Header _header;
+	std::uint64_t _checksum;
+	unsigned int _numTilesX;
+	unsigned int _numTilesY;
+	std::vector < Tile > _tiles;
+};
@@ -0,0 +1,564 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The C interface to the path distance library.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "PathDistance.h"
+#include "HeightMapDelta.h"
+#include "ResultCache.h"
+#include "Sampling.h"
+#include "Surface.h"
+
+#include <stdexcept>
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The opaque type given to the caller.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct PathDistanceSurface : public Surface
+{
+	using Surface::Surface;
+};
+struct PathDistanceCache : public ResultCache
+{
+	using ResultCache::ResultCache;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The stages in the C interface have to match the terrain's.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+static_assert ( static_cast < int > ( PATH_DISTANCE_STAGE_POINTS ) == static_cast < int > ( Terrain::STAGE_POINTS ) );
+static_assert ( static_cast < int > ( PATH_DISTANCE_STAGE_TRIANGLES ) == static_cast < int > ( Terrain::STAGE_TRIANGLES ) );
+static_assert ( static_cast < int > ( PATH_DISTANCE_STAGE_INTERSECT ) == static_cast < int > ( Terrain::STAGE_INTERSECT ) );
+static_assert ( static_cast < int > ( PATH_DISTANCE_STAGE_DISTANCE ) == static_cast < int > ( Terrain::STAGE_DISTANCE ) );
+static_assert ( static_cast < int > ( PATH_DISTANCE_NUM_STAGES ) == static_cast < int > ( Terrain::NUM_STAGES ) );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Helper functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+	// The last error message for each thread.
+	thread_local std::string lastError;
+
+	// Call the function and turn any exception into a status code.
+	template < class Function > inline int call ( Function fun )
+	{
+		try
+		{
+			fun();
+			lastError.clear();
+			return PATH_DISTANCE_OK;
+		}
+		catch ( const std::invalid_argument &e )
+		{
+			lastError = e.what();
+			return PATH_DISTANCE_INVALID_ARGUMENT;
+		}
+		catch ( const std::out_of_range &e )
+		{
+			lastError = e.what();
+			return PATH_DISTANCE_OUT_OF_RANGE;
+		}
+		catch ( const std::exception &e )
+		{
+			lastError = e.what();
+			return PATH_DISTANCE_RUNTIME_ERROR;
+		}
+		catch ( ... )
+		{
+			lastError = "Unknown exception caught";
+			return PATH_DISTANCE_UNKNOWN_ERROR;
+		}
+	}
+
+	// Make sure the pointer is not null.
+	template < class T > inline void checkPointer ( T *ptr, const char *name )
+	{
+		if ( nullptr == ptr )
+		{
+			throw std::invalid_argument ( std::string ( "Null pointer given for " ) + name );
+		}
+	}
+
+	// Copy the metrics to the caller's struct.
+	inline void copyMetrics ( const Surface::Metrics &from, PathDistanceMetrics &to )
+	{
+		to.distance = from.distance;
+		to.horizontalDistance = from.horizontalDistance;
+		to.ascent = from.ascent;
+		to.descent = from.descent;
+		to.maxSlope = from.maxSlope;
+		to.horizontalRatio = from.horizontalRatio;
+	}
+
+	// Copy the peak memory of the stages to the caller's report, if any.
+	inline void copyStages ( const Surface::StageMemory &from, PathDistanceMemoryReport *to )
+	{
+		if ( nullptr != to )
+		{
+			for ( unsigned int i = 0; i < Terrain::NUM_STAGES; ++i )
+			{
+				to->peakMemory[i] = from[i];
+			}
+		}
+	}
+} }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Load a surface from a file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSurfaceLoadFile ( unsigned int numX, unsigned int numY, const char *file, PathDistanceSurface **surface )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( file, "file" );
+		Details::checkPointer ( surface, "surface" );
+		*surface = new PathDistanceSurface ( numX, numY, std::string ( file ) );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Load a surface from a base surface and a delta file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSurfaceLoadDelta ( const PathDistanceSurface *base, const char *file, PathDistanceSurface **surface )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( base, "base" );
+		Details::checkPointer ( file, "file" );
+		Details::checkPointer ( surface, "surface" );
+		*surface = new PathDistanceSurface ( *base, std::string ( file ) );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Is the file a delta file?
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceIsDeltaFile ( const char *file )
+{
+	return ( ( ( nullptr != file ) && HeightMapDelta::isDeltaFile ( std::string ( file ) ) ) ? 1 : 0 );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Open a surface from a file in low-memory mode.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSurfaceOpenFile ( unsigned int numX, unsigned int numY, const char *file, PathDistanceSurface **surface )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( file, "file" );
+		Details::checkPointer ( surface, "surface" );
+		*surface = new PathDistanceSurface ( numX, numY, std::string ( file ), true );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Load a surface from the caller's buffer.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSurfaceLoadBuffer ( unsigned int numX, unsigned int numY, const uint8_t *heights, size_t size, PathDistanceSurface **surface )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( heights, "heights" );
+		Details::checkPointer ( surface, "surface" );
+		*surface = new PathDistanceSurface ( numX, numY, Surface::HeightsView ( heights, size ) );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the size of the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSurfaceGetSize ( const PathDistanceSurface *surface, unsigned int *numX, unsigned int *numY )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		Details::checkPointer ( numX, "numX" );
+		Details::checkPointer ( numY, "numY" );
+		*numX = surface->getNumX();
+		*numY = surface->getNumY();
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Set the size of a cell and of one step in height.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSurfaceSetResolution ( PathDistanceSurface *surface, double horizontal, double vertical )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		surface->setResolution ( horizontal, vertical );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the resolution of the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSurfaceGetResolution ( const PathDistanceSurface *surface, double *horizontal, double *vertical )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		Details::checkPointer ( horizontal, "horizontal" );
+		Details::checkPointer ( vertical, "vertical" );
+		*horizontal = surface->getHorizontalResolution();
+		*vertical = surface->getVerticalResolution();
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Turn the corridor mode on or off.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSurfaceSetCorridor ( PathDistanceSurface *surface, int state )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		surface->setCorridor ( 0 != state );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distance along the path.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceQuery ( const PathDistanceSurface *surface, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double *distance )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		Details::checkPointer ( distance, "distance" );
+		*distance = surface->getDistance ( i1, j1, i2, j2 );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the metrics along the path.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceQueryMetrics ( const PathDistanceSurface *surface, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, PathDistanceMetrics *metrics )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		Details::checkPointer ( metrics, "metrics" );
+		Details::copyMetrics ( surface->getMetrics ( i1, j1, i2, j2 ), *metrics );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the metrics along the path in low-memory mode.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceQueryMetricsLowMemory ( const PathDistanceSurface *surface, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, PathDistanceMetrics *metrics, PathDistanceMemoryReport *report )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		Details::checkPointer ( metrics, "metrics" );
+
+		Surface::StageMemory stages;
+		Details::copyMetrics ( surface->getMetrics ( i1, j1, i2, j2, stages ), *metrics );
+		Details::copyStages ( stages, report );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distance along the path in low-memory mode.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceQueryLowMemory ( const PathDistanceSurface *surface, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double *distance, PathDistanceMemoryReport *report )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		Details::checkPointer ( distance, "distance" );
+
+		Surface::StageMemory stages;
+		*distance = surface->getDistance ( i1, j1, i2, j2, stages );
+		Details::copyStages ( stages, report );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the name of the stage.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+const char *pathDistanceGetStageName ( int stage )
+{
+	if ( ( stage < 0 ) || ( stage >= PATH_DISTANCE_NUM_STAGES ) )
+	{
+		return "unknown";
+	}
+
+	return Terrain::getStageName ( static_cast < Terrain::Stage > ( stage ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distances along many paths.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceQueryBatch ( const PathDistanceSurface *surface, const unsigned int *endpoints, size_t numPaths, double *distances )
+{
+	int status = Details::call ( [&]()
+	{
+		Details::checkPointer ( surface, "surface" );
+		Details::checkPointer ( endpoints, "endpoints" );
+		Details::checkPointer ( distances, "distances" );
+	} );
+
+	if ( PATH_DISTANCE_OK != status )
+	{
+		return status;
+	}
+
+	// Remember the first error, if any.
+	std::string firstError;
+
+	// Loop over the paths.
+	for ( size_t i = 0; i < numPaths; ++i )
+	{
+		const unsigned int *e = endpoints + ( i * 4 );
+		const int answer = pathDistanceQuery ( surface, e[0], e[1], e[2], e[3], distances + i );
+
+		if ( PATH_DISTANCE_OK != answer )
+		{
+			distances[i] = -1;
+
+			if ( PATH_DISTANCE_OK == status )
+			{
+				status = answer;
+				firstError = "Path " + std::to_string ( i ) + ": " + Details::lastError;
+			}
+		}
+	}
+
+	// The last error should be the first one that happened.
+	Details::lastError = firstError;
+
+	return status;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Summarize the change in distance along random paths.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceSample (
+	const PathDistanceSurface *before,
+	const PathDistanceSurface *after,
+	size_t numSamples,
+	uint64_t seed,
+	unsigned int numThreads,
+	PathDistanceSampleStats *stats,
+	const double *quantiles,
+	size_t numQuantiles,
+	double *quantileValues )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( before, "before" );
+		Details::checkPointer ( after, "after" );
+		Details::checkPointer ( stats, "stats" );
+		if ( numQuantiles > 0 )
+		{
+			Details::checkPointer ( quantiles, "quantiles" );
+			Details::checkPointer ( quantileValues, "quantileValues" );
+		}
+
+		const Sampling::Summary summary = Sampling::run ( *before, *after, numSamples, seed, numThreads );
+
+		stats->count = summary.stats.getCount();
+		stats->failures = summary.failures;
+		stats->mean = summary.stats.getMean();
+		stats->variance = summary.stats.getVariance();
+		stats->min = summary.stats.getMin();
+		stats->max = summary.stats.getMax();
+
+		for ( size_t i = 0; i < numQuantiles; ++i )
+		{
+			quantileValues[i] = ( ( 0 == summary.sketch.getCount() ) ? 0.0 : summary.sketch.getQuantile ( quantiles[i] ) );
+		}
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Free the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void pathDistanceSurfaceFree ( PathDistanceSurface *surface )
+{
+	delete surface;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Open the cache.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceCacheOpen ( const char *directory, PathDistanceCache **cache )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( directory, "directory" );
+		Details::checkPointer ( cache, "cache" );
+		*cache = new PathDistanceCache ( std::string ( directory ) );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Look for the distance in the cache.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceCacheFind ( PathDistanceCache *cache, const char *file, unsigned int numX, unsigned int numY, double horizontalResolution, double verticalResolution, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double *distance, int *found )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( cache, "cache" );
+		Details::checkPointer ( file, "file" );
+		Details::checkPointer ( distance, "distance" );
+		Details::checkPointer ( found, "found" );
+		const ResultCache::Key key = cache->makeKey ( std::string ( file ), numX, numY, horizontalResolution, verticalResolution, i1, j1, i2, j2 );
+		*found = ( cache->find ( key, *distance ) ? 1 : 0 );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Save the distance in the cache.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceCacheInsert ( PathDistanceCache *cache, const char *file, unsigned int numX, unsigned int numY, double horizontalResolution, double verticalResolution, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double distance )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( cache, "cache" );
+		Details::checkPointer ( file, "file" );
+		const ResultCache::Key key = cache->makeKey ( std::string ( file ), numX, numY, horizontalResolution, verticalResolution, i1, j1, i2, j2 );
+		cache->insert ( key, distance );
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the number of hits and misses.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pathDistanceCacheGetStats ( const PathDistanceCache *cache, size_t *hits, size_t *misses )
+{
+	return Details::call ( [&]()
+	{
+		Details::checkPointer ( cache, "cache" );
+		Details::checkPointer ( hits, "hits" );
+		Details::checkPointer ( misses, "misses" );
+		*hits = cache->getHits();
+		*misses = cache->getMisses();
+	} );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Free the cache.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void pathDistanceCacheFree ( PathDistanceCache *cache )
+{
+	delete cache;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the description of the last error on this thread.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+const char *pathDistanceGetLastError()
+{
+	return Details::lastError.c_str();
+}
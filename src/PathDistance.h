@@ -0,0 +1,381 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The C interface to the path distance library.
+//
+//	Every function that can fail returns one of the status codes below.
+//	When it is not PATH_DISTANCE_OK, pathDistanceGetLastError() returns a
+//	description of the error for the calling thread.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Symbol visibility when building or using a shared library.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#if defined ( _WIN32 ) && defined ( PATH_DISTANCE_SHARED )
+	#ifdef PATH_DISTANCE_EXPORTS
+		#define PATH_DISTANCE_API __declspec ( dllexport )
+	#else
+		#define PATH_DISTANCE_API __declspec ( dllimport )
+	#endif
+#elif defined ( __GNUC__ ) && defined ( PATH_DISTANCE_SHARED )
+	#define PATH_DISTANCE_API __attribute__ ( ( visibility ( "default" ) ) )
+#else
+	#define PATH_DISTANCE_API
+#endif
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Status codes.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+enum
+{
+	PATH_DISTANCE_OK = 0,
+	PATH_DISTANCE_INVALID_ARGUMENT = 1,
+	PATH_DISTANCE_OUT_OF_RANGE = 2,
+	PATH_DISTANCE_RUNTIME_ERROR = 3,
+	PATH_DISTANCE_UNKNOWN_ERROR = 4
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The surface is opaque to the caller.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct PathDistanceSurface PathDistanceSurface;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The stages of finding the path, and the most bytes the query held at
+//	once in each one. These are the query's own buffers, not the whole
+//	process, so they do not depend on the system or on other threads.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+enum
+{
+	PATH_DISTANCE_STAGE_POINTS = 0,
+	PATH_DISTANCE_STAGE_TRIANGLES = 1,
+	PATH_DISTANCE_STAGE_INTERSECT = 2,
+	PATH_DISTANCE_STAGE_DISTANCE = 3,
+	PATH_DISTANCE_NUM_STAGES = 4
+};
+
+typedef struct PathDistanceMemoryReport
+{
+	size_t peakMemory[PATH_DISTANCE_NUM_STAGES];
+} PathDistanceMemoryReport;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Load a surface from a file of numX * numY heights. The file can also be
+//	a tiled height map file made by convert_height_map, in which case numX
+//	and numY can be zero to use the size in the file, and the resolution
+//	comes from the file too.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSurfaceLoadFile ( unsigned int numX, unsigned int numY, const char *file, PathDistanceSurface **surface );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Load a surface from the base surface and a delta file of the changes
+//	to it, made by convert_height_map --delta. If the base has its heights
+//	the changes go on top of them, otherwise the base file is read in the
+//	same pass. The new surface does not need the base after this.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSurfaceLoadDelta ( const PathDistanceSurface *base, const char *file, PathDistanceSurface **surface );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Is the file a delta file? Returns 1 or 0.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceIsDeltaFile ( const char *file );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Open a surface from a file of numX * numY heights in low-memory mode.
+//	The heights are not kept. Each query streams them from the file and
+//	frees each stage as soon as the next one has consumed it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSurfaceOpenFile ( unsigned int numX, unsigned int numY, const char *file, PathDistanceSurface **surface );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Load a surface from the caller's buffer of numX * numY heights.
+//	The buffer is not copied, so it has to outlive the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSurfaceLoadBuffer ( unsigned int numX, unsigned int numY, const uint8_t *heights, size_t size, PathDistanceSurface **surface );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the size of the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSurfaceGetSize ( const PathDistanceSurface *surface, unsigned int *numX, unsigned int *numY );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Set the size of a cell and of one step in height, in meters. The
+//	default is 30 and 11 unless the file said otherwise.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSurfaceSetResolution ( PathDistanceSurface *surface, double horizontal, double vertical );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the size of a cell and of one step in height, in meters.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSurfaceGetResolution ( const PathDistanceSurface *surface, double *horizontal, double *vertical );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Turn the corridor mode on (1) or off (0). It is on by default. When on,
+//	each query only makes the mesh for the cells near the path that could
+//	be part of it. The answers are the same either way.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSurfaceSetCorridor ( PathDistanceSurface *surface, int state );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distance along the path from [i1,j1] to [i2,j2].
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceQuery ( const PathDistanceSurface *surface, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double *distance );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distance along the path in low-memory mode, and the peak
+//	memory of each stage. The report can be null. Low-memory queries can
+//	run at the same time as each other and as sampling.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceQueryLowMemory ( const PathDistanceSurface *surface, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double *distance, PathDistanceMemoryReport *report );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	What we measure along a path. Distances are in meters. The ascent and
+//	descent are the total climb and drop going from [i1,j1] to [i2,j2].
+//	The slope is rise over run. The ratio is the horizontal distance over
+//	the distance over the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct PathDistanceMetrics
+{
+	double distance;
+	double horizontalDistance;
+	double ascent;
+	double descent;
+	double maxSlope;
+	double horizontalRatio;
+} PathDistanceMetrics;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the metrics along the path from [i1,j1] to [i2,j2]. They are all
+//	found in one pass, so this costs about the same as pathDistanceQuery.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceQueryMetrics ( const PathDistanceSurface *surface, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, PathDistanceMetrics *metrics );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the metrics along the path in low-memory mode, and the peak
+//	memory of each stage like pathDistanceQueryLowMemory. The
+//	report can be null.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceQueryMetricsLowMemory ( const PathDistanceSurface *surface, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, PathDistanceMetrics *metrics, PathDistanceMemoryReport *report );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the name of the stage.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API const char *pathDistanceGetStageName ( int stage );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distances along many paths. The endpoints are numPaths groups
+//	of i1, j1, i2, j2. A path that fails gets a distance of -1 and the
+//	status of the first failure is returned after all paths are tried.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceQueryBatch ( const PathDistanceSurface *surface, const unsigned int *endpoints, size_t numPaths, double *distances );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The summary of the change in distance, after minus before, along
+//	random paths. Failures are paths that could not be measured.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct PathDistanceSampleStats
+{
+	size_t count;
+	size_t failures;
+	double mean;
+	double variance;
+	double min;
+	double max;
+} PathDistanceSampleStats;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Measure numSamples random paths over both surfaces and summarize the
+//	change in distance. Zero threads means one for each core. The answer
+//	only depends on the seed and the number of threads. The approximate
+//	quantiles at the given probabilities go in quantileValues, which can
+//	be null when numQuantiles is zero.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceSample (
+	const PathDistanceSurface *before,
+	const PathDistanceSurface *after,
+	size_t numSamples,
+	uint64_t seed,
+	unsigned int numThreads,
+	PathDistanceSampleStats *stats,
+	const double *quantiles,
+	size_t numQuantiles,
+	double *quantileValues );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Free the surface. Passing null is fine.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API void pathDistanceSurfaceFree ( PathDistanceSurface *surface );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A cache of answers in a directory on disk. It is keyed by a hash of the
+//	contents of the height file, the size, the resolution, the engine
+//	version, and the end points of the path. Many threads and processes
+//	can use the same directory at once. The resolution is the default for
+//	raw files and the one in the header for tiled files, so do not use the
+//	cache with surfaces that were given a different resolution. For delta
+//	files the key has the hash of the heights after the changes, and the
+//	resolution of the base has to be given.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct PathDistanceCache PathDistanceCache;
+
+PATH_DISTANCE_API int pathDistanceCacheOpen ( const char *directory, PathDistanceCache **cache );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Look for the distance along the path over the file with the given
+//	resolution. A resolution of zero is the one a surface loaded from the
+//	file would have. The height file is not read when the answer is found.
+//	Found is set to 1 or 0.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceCacheFind ( PathDistanceCache *cache, const char *file, unsigned int numX, unsigned int numY, double horizontalResolution, double verticalResolution, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double *distance, int *found );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Save the distance along the path over the file, found with the given
+//	resolution. Use pathDistanceSurfaceGetResolution to get it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceCacheInsert ( PathDistanceCache *cache, const char *file, unsigned int numX, unsigned int numY, double horizontalResolution, double verticalResolution, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double distance );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the number of hits and misses so far.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API int pathDistanceCacheGetStats ( const PathDistanceCache *cache, size_t *hits, size_t *misses );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Free the cache. The directory stays. Passing null is fine.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API void pathDistanceCacheFree ( PathDistanceCache *cache );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the description of the last error on this thread.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+PATH_DISTANCE_API const char *pathDistanceGetLastError ( void );
+
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
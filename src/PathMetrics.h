@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Accumulators for what we measure along the path. Each one looks at the
+//	line segments of the path in order and fills in its part of the Metrics.
+//	They are put together at compile time with Fused, so one loop over the
+//	line segments does all of them, and the ones not asked for cost nothing.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Beginning of the namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace PathMetrics {
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	What we measure along the path. Slopes are rise over run.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct Metrics
+{
+	double distance = 0;
+	double horizontalDistance = 0;
+	double ascent = 0;
+	double descent = 0;
+	double maxSlope = 0;
+	double horizontalRatio = 0;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	One line segment of the path, pointing from the start of the path toward
+//	the end of it. The lengths are found the first time an accumulator asks
+//	for them and shared with the rest, so the ones nobody asks for cost
+//	nothing.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+template < class LineSegment > struct Step
+{
+	Step ( const LineSegment &l, double dirX, double dirY ) :
+		line ( l ),
+		dx ( l[1][0] - l[0][0] ),
+		dy ( l[1][1] - l[0][1] ),
+		dz ( l[1][2] - l[0][2] )
+	{
+		if ( ( ( dx * dirX ) + ( dy * dirY ) ) < 0 )
+		{
+			dx = -dx;
+			dy = -dy;
+			dz = -dz;
+		}
+	}
+
+	double getLength() const
+	{
+		if ( _length < 0 )
+		{
+			_length = std::sqrt ( line.squared_length() );
+		}
+		return _length;
+	}
+
+	double getHorizontalLength() const
+	{
+		if ( _horizontalLength < 0 )
+		{
+			_horizontalLength = std::sqrt ( ( dx * dx ) + ( dy * dy ) );
+		}
+		return _horizontalLength;
+	}
+
+	const LineSegment &line;
+	double dx;
+	double dy;
+	double dz;
+
+private:
+
+	mutable double _length = -1;
+	mutable double _horizontalLength = -1;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The distance over the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct Distance
+{
+	template < class S > void add ( const S &step )
+	{
+		_dist += step.getLength();
+	}
+	void get ( Metrics &metrics ) const
+	{
+		metrics.distance = _dist;
+	}
+
+private:
+
+	double _dist = 0;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The distance as seen from above.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct HorizontalDistance
+{
+	template < class S > void add ( const S &step )
+	{
+		_dist += step.getHorizontalLength();
+	}
+	void get ( Metrics &metrics ) const
+	{
+		metrics.horizontalDistance = _dist;
+	}
+
+private:
+
+	double _dist = 0;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The total climb and the total drop going from the start to the end.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct Ascent
+{
+	template < class S > void add ( const S &step )
+	{
+		_total += std::max ( step.dz, 0.0 );
+	}
+	void get ( Metrics &metrics ) const
+	{
+		metrics.ascent = _total;
+	}
+
+private:
+
+	double _total = 0;
+};
+
+struct Descent
+{
+	template < class S > void add ( const S &step )
+	{
+		_total += std::max ( -step.dz, 0.0 );
+	}
+	void get ( Metrics &metrics ) const
+	{
+		metrics.descent = _total;
+	}
+
+private:
+
+	double _total = 0;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The steepest line segment, up or down.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct MaxSlope
+{
+	template < class S > void add ( const S &step )
+	{
+		const double run = step.getHorizontalLength();
+		if ( run > 0 )
+		{
+			_max = std::max ( _max, ( std::fabs ( step.dz ) / run ) );
+		}
+	}
+	void get ( Metrics &metrics ) const
+	{
+		metrics.maxSlope = _max;
+	}
+
+private:
+
+	double _max = 0;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The distance seen from above over the distance over the surface.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct HorizontalRatio
+{
+	template < class S > void add ( const S &step )
+	{
+		_horizontal += step.getHorizontalLength();
+		_surface += step.getLength();
+	}
+	void get ( Metrics &metrics ) const
+	{
+		metrics.horizontalRatio = ( ( _surface > 0 ) ? ( _horizontal / _surface ) : 0 );
+	}
+
+private:
+
+	double _horizontal = 0;
+	double _surface = 0;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Run all the given accumulators on each line segment.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+template < class ... Accumulators > struct Fused
+{
+	template < class S > void add ( const S &step )
+	{
+		std::apply ( [&] ( Accumulators & ... a ) { ( a.add ( step ), ... ); }, _accumulators );
+	}
+	void get ( Metrics &metrics ) const
+	{
+		std::apply ( [&] ( const Accumulators & ... a ) { ( a.get ( metrics ), ... ); }, _accumulators );
+	}
+
+private:
+
+	std::tuple < Accumulators ... > _accumulators;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The sets we use.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+typedef Fused < Distance > DistanceOnly;
+typedef Fused < Distance, HorizontalDistance, Ascent, Descent, MaxSlope, HorizontalRatio > All;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	End of the namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace PathMetrics
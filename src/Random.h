@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A counter-based random number generator. The n'th number of a stream
+//	is a hash of the seed, the stream, and n, so streams do not share any
+//	state and every number can be found again from those three values.
+//
+//	References:
+//	https://prng.di.unimi.it/splitmix64.c
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The generator for one stream.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class Random
+{
+public:
+
+	Random ( std::uint64_t seed, std::uint64_t stream ) :
+		_key ( Random::mix ( seed ^ Random::mix ( stream + 0x9e3779b97f4a7c15ull ) ) ),
+		_counter ( 0 )
+	{
+	}
+
+	// Get the next number.
+	std::uint64_t next()
+	{
+		return Random::mix ( _key + ( ( ++_counter ) * 0x9e3779b97f4a7c15ull ) );
+	}
+
+	// Get the next number in the range [0, n). The bias is negligible when
+	// n is much smaller than 2^64, which it always is for grid indices.
+	std::uint64_t next ( std::uint64_t n )
+	{
+		return ( this->next() % n );
+	}
+
+	// Get the number of values generated so far.
+	std::uint64_t getCounter() const { return _counter; }
+
+	// The SplitMix64 finalizer.
+	static std::uint64_t mix ( std::uint64_t z )
+	{
+		z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+		z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+		return ( z ^ ( z >> 31 ) );
+	}
+
+private:
+
+	std::uint64_t _key;
+	std::uint64_t _counter;
+};
@@ -0,0 +1,329 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A cache of path distances in a directory.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "ResultCache.h"
+#include "Constants.h"
+#include "HeightMapDelta.h"
+#include "HeightMapFile.h"
+#include "Hasher.h"
+#include "Random.h"
+#include "Tools.h"
+
+#include <bit>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Helper functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+	const char *const MAGIC = "PDRC";
+	const unsigned int VERSION = 1;
+
+	// Format the number as 16 hex digits.
+	inline std::string toHex ( std::uint64_t value )
+	{
+		std::ostringstream out;
+		out << std::hex << std::setw ( 16 ) << std::setfill ( '0' ) << value;
+		return out.str();
+	}
+
+	// Read the whole small file, or return false.
+	inline bool readFile ( const std::filesystem::path &path, std::string &contents )
+	{
+		std::ifstream in ( path, std::ios::binary );
+		if ( !in.is_open() )
+		{
+			return false;
+		}
+		std::ostringstream out;
+		out << in.rdbuf();
+		contents = out.str();
+		return true;
+	}
+
+	// Format the key, which is also what the answer's file starts with.
+	inline std::string formatKey ( const ResultCache::Key &key )
+	{
+		std::ostringstream out;
+		out << MAGIC << ' ' << VERSION << ' ' << toHex ( key.content ) << ' ';
+		out << key.numX << ' ' << key.numY << ' ';
+		out << toHex ( std::bit_cast < std::uint64_t > ( key.horizontalResolution ) ) << ' ';
+		out << toHex ( std::bit_cast < std::uint64_t > ( key.verticalResolution ) ) << ' ';
+		out << key.version << ' ';
+		out << key.i1 << ' ' << key.j1 << ' ' << key.i2 << ' ' << key.j2;
+		return out.str();
+	}
+
+	// Make sure the size the file says matches the given one, if any.
+	inline void checkSize ( const std::string &file, unsigned int numX, unsigned int numY, unsigned int fileX, unsigned int fileY )
+	{
+		if ( ( ( 0 != numX ) || ( 0 != numY ) ) && ( ( fileX != numX ) || ( fileY != numY ) ) )
+		{
+			std::ostringstream out;
+			out << "Given size " << numX << " by " << numY << " but height map file " << file << " is " << fileX << " by " << fileY;
+			throw std::invalid_argument ( out.str() );
+		}
+	}
+
+	// Make a name for a temporary file that no other thread or process
+	// will also make.
+	inline std::string makeTemporaryName()
+	{
+		thread_local Random random (
+			static_cast < std::uint64_t > ( std::chrono::steady_clock::now().time_since_epoch().count() ),
+			std::hash < std::thread::id > () ( std::this_thread::get_id() )
+		);
+		return ".tmp." + toHex ( random.next() );
+	}
+} }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+ResultCache::ResultCache ( const std::string &directory ) :
+	_directory ( directory ),
+	_hits ( 0 ),
+	_misses ( 0 )
+{
+	std::filesystem::create_directories ( _directory / "results" );
+	std::filesystem::create_directories ( _directory / "files" );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Hash all the bytes in the file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::uint64_t ResultCache::hashFile ( const std::string &file )
+{
+	std::ifstream in ( file.c_str(), std::ios::binary );
+	if ( !in.is_open() )
+	{
+		throw std::runtime_error ( "Could not open input file: " + file );
+	}
+
+	Hasher hasher;
+	std::vector < char > buffer ( 1 << 20 );
+	while ( in )
+	{
+		in.read ( buffer.data(), buffer.size() );
+		hasher.update ( buffer.data(), static_cast < std::size_t > ( in.gcount() ) );
+	}
+
+	return hasher.getValue();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the hash of the file's contents, without reading them if we can.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::uint64_t ResultCache::_getContentHash ( const std::string &file )
+{
+	// Tiled files have a checksum that covers everything.
+	if ( HeightMapFile::isHeightMapFile ( file ) )
+	{
+		return HeightMapFile ( file ).getChecksum();
+	}
+
+	// What we know about the file without reading it.
+	typedef std::filesystem::file_time_type FileTime;
+	const std::filesystem::path path = std::filesystem::absolute ( file );
+	const std::uintmax_t size = std::filesystem::file_size ( path );
+	const FileTime::rep time = std::filesystem::last_write_time ( path ).time_since_epoch().count();
+
+	std::ostringstream out;
+	out << path.string() << '\n' << size << '\n' << time << '\n';
+	const std::string stamp = out.str();
+
+	// A file can change again without its time changing, if it is within
+	// the resolution of the file system's clock. So a hash is only trusted
+	// if it was found more than a second after the file last changed.
+	const FileTime::rep oneSecond = std::chrono::duration_cast < FileTime::duration > ( std::chrono::seconds ( 1 ) ).count();
+
+	// Have we hashed this file already?
+	const std::filesystem::path memo = _directory / "files" / Details::toHex ( Tools::hash ( stamp.data(), stamp.size() ) );
+	std::string contents;
+	if ( Details::readFile ( memo, contents ) && ( 0 == contents.compare ( 0, stamp.size(), stamp ) ) )
+	{
+		std::istringstream in ( contents.substr ( stamp.size() ) );
+		std::uint64_t answer = 0;
+		FileTime::rep hashed = 0;
+		if ( ( in >> std::hex >> answer >> std::dec >> hashed ) && ( ( hashed - time ) > oneSecond ) )
+		{
+			return answer;
+		}
+	}
+
+	// Hash it and remember when. The time is taken first, so that a change
+	// while we read makes it look too soon.
+	const FileTime::rep hashed = FileTime::clock::now().time_since_epoch().count();
+	const std::uint64_t answer = ResultCache::hashFile ( file );
+	std::ostringstream line;
+	line << Details::toHex ( answer ) << ' ' << hashed << '\n';
+	this->_write ( memo, stamp + line.str() );
+	return answer;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the key for the path over the file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+ResultCache::Key ResultCache::makeKey ( const std::string &file, unsigned int numX, unsigned int numY, double horizontalResolution, double verticalResolution, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2 )
+{
+	Key key;
+	key.numX = numX;
+	key.numY = numY;
+	key.horizontalResolution = Constants::DEFAULT_HORIZONTAL_RESOLUTION;
+	key.verticalResolution = Constants::DEFAULT_VERTICAL_RESOLUTION;
+	key.version = Constants::ENGINE_VERSION;
+	key.i1 = i1;
+	key.j1 = j1;
+	key.i2 = i2;
+	key.j2 = j2;
+
+	// Tiled files say what their size and resolution are.
+	if ( HeightMapFile::isHeightMapFile ( file ) )
+	{
+		const HeightMapFile::Header header = HeightMapFile ( file ).getHeader();
+		Details::checkSize ( file, numX, numY, header.numX, header.numY );
+		key.numX = header.numX;
+		key.numY = header.numY;
+		key.horizontalResolution = header.horizontalResolution;
+		key.verticalResolution = header.verticalResolution;
+	}
+
+	// Delta files say what their size is. They have the resolution of the
+	// base, which the caller has to give.
+	const bool delta = HeightMapDelta::isDeltaFile ( file );
+	std::uint64_t afterHash = 0;
+	if ( delta )
+	{
+		const HeightMapDelta::Header header = HeightMapDelta ( file ).getHeader();
+		Details::checkSize ( file, numX, numY, header.numX, header.numY );
+		key.numX = header.numX;
+		key.numY = header.numY;
+		afterHash = header.afterHash;
+	}
+
+	// A resolution given by the caller is what the answer was found with.
+	if ( ( 0 != horizontalResolution ) || ( 0 != verticalResolution ) )
+	{
+		if ( !( horizontalResolution > 0 ) || !( verticalResolution > 0 ) )
+		{
+			std::ostringstream out;
+			out << "Resolution must be greater than zero, given horizontal = " << horizontalResolution << " and vertical = " << verticalResolution;
+			throw std::invalid_argument ( out.str() );
+		}
+		key.horizontalResolution = horizontalResolution;
+		key.verticalResolution = verticalResolution;
+	}
+
+	// The hash of the heights after a delta is the same as the hash of a
+	// raw file of those heights, so they share answers.
+	key.content = ( delta ? afterHash : this->_getContentHash ( file ) );
+	return key;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Look for the answer.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+bool ResultCache::find ( const Key &key, double &distance )
+{
+	const std::string text = Details::formatKey ( key );
+	const std::filesystem::path path = _directory / "results" / Details::toHex ( Tools::hash ( text.data(), text.size() ) );
+
+	// The whole key is in the file, so a hash collision is not a hit.
+	std::string contents;
+	if ( Details::readFile ( path, contents ) && ( 0 == contents.compare ( 0, text.size(), text ) ) )
+	{
+		std::istringstream in ( contents.substr ( text.size() ) );
+		std::uint64_t bits = 0;
+		if ( in >> std::hex >> bits )
+		{
+			distance = std::bit_cast < double > ( bits );
+			++_hits;
+			return true;
+		}
+	}
+
+	++_misses;
+	return false;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Save the answer.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void ResultCache::insert ( const Key &key, double distance )
+{
+	const std::string text = Details::formatKey ( key );
+	const std::filesystem::path path = _directory / "results" / Details::toHex ( Tools::hash ( text.data(), text.size() ) );
+	this->_write ( path, text + ' ' + Details::toHex ( std::bit_cast < std::uint64_t > ( distance ) ) + '\n' );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Write the file under a temporary name and then rename it, so readers
+//	never see part of it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void ResultCache::_write ( const std::filesystem::path &path, const std::string &contents ) const
+{
+	const std::filesystem::path temporary = path.string() + Details::makeTemporaryName();
+
+	{
+		std::ofstream out ( temporary, std::ios::binary | std::ios::trunc );
+		out << contents;
+		out.close();
+		if ( !out )
+		{
+			std::error_code ec;
+			std::filesystem::remove ( temporary, ec );
+			throw std::runtime_error ( "Could not write cache file: " + temporary.string() );
+		}
+	}
+
+	// If this fails another writer got there first, with the same answer.
+	std::error_code ec;
+	std::filesystem::rename ( temporary, path, ec );
+	if ( ec )
+	{
+		std::filesystem::remove ( temporary, ec );
+	}
+}
@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A cache of path distances in a directory, so that the same path over
+//	the same heights is only found once.
+//
+//	Each answer is its own small file, named by the hash of its key. The
+//	key is a hash of the contents of the height file, the size, the
+//	resolution, the engine version, and the end points of the path. The
+//	file is written under a temporary name and then renamed, so many
+//	processes and threads can read and write the same directory.
+//
+//	Finding the hash of a raw height file means reading all of it, so it
+//	is saved too, keyed by the file's absolute path, size, and time of
+//	last change. It is only used if it was found more than a second after
+//	that time, since a change within the file system's clock resolution
+//	would not change the time. A tiled height map file already has a checksum in its
+//	header, and a delta file has the hash of the heights after the changes.
+//	Either way a hit does not read the heights.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The class that holds the cache.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class ResultCache
+{
+public:
+
+	// What an answer depends on.
+	struct Key
+	{
+		std::uint64_t content = 0;
+		unsigned int numX = 0;
+		unsigned int numY = 0;
+		double horizontalResolution = 0;
+		double verticalResolution = 0;
+		unsigned int version = 0;
+		unsigned int i1 = 0;
+		unsigned int j1 = 0;
+		unsigned int i2 = 0;
+		unsigned int j2 = 0;
+
+		bool operator == ( const Key & ) const = default;
+	};
+
+	// Use the directory, which is made if needed.
+	explicit ResultCache ( const std::string &directory );
+
+	// The default destructor is fine.
+	~ResultCache() = default;
+
+	// Not copyable or movable.
+	ResultCache ( const ResultCache & ) = delete;
+	ResultCache ( ResultCache && ) = delete;
+	ResultCache & operator = ( const ResultCache & ) = delete;
+	ResultCache & operator = ( ResultCache && ) = delete;
+
+	// Make the key for the path over the file with the given resolution. A
+	// size or resolution of zero is the one Surface would use for the file.
+	// A delta file has the resolution of its base, so give that one.
+	Key makeKey ( const std::string &file, unsigned int numX, unsigned int numY, double horizontalResolution, double verticalResolution, unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2 );
+
+	// Look for the answer. Counts a hit or a miss.
+	bool find ( const Key &, double &distance );
+
+	// Save the answer.
+	void insert ( const Key &, double distance );
+
+	// Get the number of hits and misses so far.
+	std::size_t getHits() const { return _hits; }
+	std::size_t getMisses() const { return _misses; }
+
+	// Hash all the bytes in the file.
+	static std::uint64_t hashFile ( const std::string &file );
+
+protected:
+
+	std::uint64_t _getContentHash ( const std::string &file );
+
+	void _write ( const std::filesystem::path &, const std::string &contents ) const;
+
+private:
+
+	std::filesystem::path _directory;
+	std::atomic < std::size_t > _hits;
+	std::atomic < std::size_t > _misses;
+};
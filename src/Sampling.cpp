@@ -0,0 +1,159 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Sample random paths over two surfaces and summarize the change in the
+//	distances along them.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Sampling.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Helper functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+	// Sample the paths in the range [first, last) with the given stream.
+	inline void sample (
+		const Surface &before,
+		const Surface &after,
+		std::size_t first,
+		std::size_t last,
+		std::uint64_t seed,
+		std::uint64_t stream,
+		Sampling::Summary &summary )
+	{
+		Random random ( seed, stream );
+
+		const std::uint64_t numX = before.getNumX();
+		const std::uint64_t numY = before.getNumY();
+
+		for ( std::size_t k = first; k < last; ++k )
+		{
+			// Make a path with two different end points.
+			unsigned int i1, j1, i2, j2;
+			do
+			{
+				i1 = static_cast < unsigned int > ( random.next ( numY ) );
+				j1 = static_cast < unsigned int > ( random.next ( numX ) );
+				i2 = static_cast < unsigned int > ( random.next ( numY ) );
+				j2 = static_cast < unsigned int > ( random.next ( numX ) );
+			}
+			while ( ( i1 == i2 ) && ( j1 == j2 ) );
+
+			// Some paths can not be measured because of where they are. We
+			// count them and move on. Anything else is a real error.
+			try
+			{
+				const double d1 = before.getDistance ( i1, j1, i2, j2 );
+				const double d2 = after.getDistance ( i1, j1, i2, j2 );
+				summary.stats.add ( d2 - d1 );
+				summary.sketch.add ( d2 - d1 );
+			}
+			catch ( const Terrain::GeometryError & )
+			{
+				++summary.failures;
+			}
+		}
+	}
+
+	// Get where the block of samples for the thread starts. The first ones
+	// get one more sample each when they do not divide evenly. Multiplying
+	// the number of samples by the thread first could overflow.
+	inline std::size_t getBlockStart ( std::size_t numSamples, unsigned int numThreads, unsigned int t )
+	{
+		return ( ( ( numSamples / numThreads ) * t ) + std::min < std::size_t > ( t, numSamples % numThreads ) );
+	}
+} }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Sample the paths.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Sampling::Summary Sampling::run ( const Surface &before, const Surface &after, std::size_t numSamples, std::uint64_t seed, unsigned int numThreads )
+{
+	// Make sure the surfaces line up.
+	if ( ( before.getNumX() != after.getNumX() ) || ( before.getNumY() != after.getNumY() ) )
+	{
+		throw std::invalid_argument ( "Surfaces to sample are not the same size" );
+	}
+
+	// Use all the cores if we were not told how many threads.
+	if ( 0 == numThreads )
+	{
+		numThreads = std::max ( 1u, std::thread::hardware_concurrency() );
+	}
+
+	// Each thread gets a contiguous block of samples.
+	std::vector < Summary > summaries ( numThreads );
+	std::vector < std::exception_ptr > errors ( numThreads );
+	std::vector < std::thread > threads;
+	threads.reserve ( numThreads );
+
+	// Wait for the threads that started if one of them can not, because
+	// destroying a running thread ends the program.
+	auto join = [&]()
+	{
+		for ( auto &thread : threads )
+		{
+			if ( thread.joinable() )
+			{
+				thread.join();
+			}
+		}
+	};
+
+	try
+	{
+		for ( unsigned int t = 0; t < numThreads; ++t )
+		{
+			const std::size_t first = Details::getBlockStart ( numSamples, numThreads, t );
+			const std::size_t last = Details::getBlockStart ( numSamples, numThreads, t + 1 );
+
+			threads.push_back ( std::thread ( [&, t, first, last]()
+			{
+				try
+				{
+					Details::sample ( before, after, first, last, seed, t, summaries[t] );
+				}
+				catch ( ... )
+				{
+					errors[t] = std::current_exception();
+				}
+			} ) );
+		}
+	}
+	catch ( ... )
+	{
+		join();
+		throw;
+	}
+
+	join();
+
+	// Merge in thread order so the answer is always the same.
+	Summary answer;
+	for ( unsigned int t = 0; t < numThreads; ++t )
+	{
+		if ( errors[t] )
+		{
+			std::rethrow_exception ( errors[t] );
+		}
+		answer.merge ( summaries[t] );
+	}
+
+	return answer;
+}
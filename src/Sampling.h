@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Sample random paths over two surfaces and summarize the change in the
+//	distances along them.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Statistics.h"
+#include "Surface.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Beginning of the namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace Sampling {
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The summary of the change in distance, which is after minus before.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct Summary
+{
+	RunningStats stats;
+	QuantileSketch sketch;
+	std::size_t failures = 0;
+
+	void merge ( const Summary &other )
+	{
+		stats.merge ( other.stats );
+		sketch.merge ( other.sketch );
+		failures += other.failures;
+	}
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Sample the paths. Each thread gets its own block of the samples and its
+//	own random stream, and the results are merged in thread order, so the
+//	answer only depends on the seed and the number of threads. Zero threads
+//	means one for each core.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Summary run ( const Surface &before, const Surface &after, std::size_t numSamples, std::uint64_t seed, unsigned int numThreads );
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	End of the namespace.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+} // namespace Sampling
@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Summary statistics that are built one value at a time and can be merged.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Statistics.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+RunningStats::RunningStats() :
+	_count ( 0 ),
+	_mean ( 0 ),
+	_m2 ( 0 ),
+	_min ( std::numeric_limits < double >::max() ),
+	_max ( std::numeric_limits < double >::lowest() )
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Add a value.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void RunningStats::add ( double value )
+{
+	++_count;
+	const double delta = value - _mean;
+	_mean += delta / static_cast < double > ( _count );
+	_m2 += delta * ( value - _mean );
+	_min = std::min ( _min, value );
+	_max = std::max ( _max, value );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Add the other values to ours.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void RunningStats::merge ( const RunningStats &other )
+{
+	if ( 0 == other._count )
+	{
+		return;
+	}
+
+	if ( 0 == _count )
+	{
+		*this = other;
+		return;
+	}
+
+	const double na = static_cast < double > ( _count );
+	const double nb = static_cast < double > ( other._count );
+	const double n = na + nb;
+	const double delta = other._mean - _mean;
+
+	_mean += delta * ( nb / n );
+	_m2 += other._m2 + ( delta * delta * ( na * nb / n ) );
+	_count += other._count;
+	_min = std::min ( _min, other._min );
+	_max = std::max ( _max, other._max );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the sample variance.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+double RunningStats::getVariance() const
+{
+	return ( ( _count < 2 ) ? 0.0 : ( _m2 / static_cast < double > ( _count - 1 ) ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+QuantileSketch::QuantileSketch ( std::size_t k ) :
+	_k ( k ),
+	_count ( 0 ),
+	_levels()
+{
+	if ( _k < 2 )
+	{
+		throw std::invalid_argument ( "Quantile sketch needs at least two values per level" );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Add a value.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void QuantileSketch::add ( double value )
+{
+	if ( _levels.empty() )
+	{
+		_levels.resize ( 1 );
+	}
+
+	_levels[0].values.push_back ( value );
+	++_count;
+
+	if ( _levels[0].values.size() >= _k )
+	{
+		this->_compress ( 0 );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Add the other values to ours.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void QuantileSketch::merge ( const QuantileSketch &other )
+{
+	if ( _k != other._k )
+	{
+		throw std::invalid_argument ( "Can not merge quantile sketches of different sizes" );
+	}
+
+	if ( _levels.size() < other._levels.size() )
+	{
+		_levels.resize ( other._levels.size() );
+	}
+
+	for ( std::size_t i = 0; i < other._levels.size(); ++i )
+	{
+		const Values &values = other._levels[i].values;
+		_levels[i].values.insert ( _levels[i].values.end(), values.begin(), values.end() );
+	}
+
+	_count += other._count;
+
+	// Compress from the bottom up because each one can fill the next level.
+	for ( std::size_t i = 0; i < _levels.size(); ++i )
+	{
+		if ( _levels[i].values.size() >= _k )
+		{
+			this->_compress ( i );
+		}
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Move every other value of the level to the next one.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void QuantileSketch::_compress ( std::size_t level )
+{
+	if ( ( level + 1 ) >= _levels.size() )
+	{
+		_levels.resize ( level + 2 );
+	}
+
+	Values &values = _levels[level].values;
+	Values &next = _levels[level + 1].values;
+	std::sort ( values.begin(), values.end() );
+
+	// With an odd number of values the largest one stays behind.
+	const std::size_t numPairs = values.size() / 2;
+	const std::size_t offset = _levels[level].offset;
+	for ( std::size_t i = 0; i < numPairs; ++i )
+	{
+		next.push_back ( values[2 * i + offset] );
+	}
+
+	Values remaining;
+	if ( 1 == ( values.size() % 2 ) )
+	{
+		remaining.push_back ( values.back() );
+	}
+	values = std::move ( remaining );
+
+	// Take the other half next time.
+	_levels[level].offset = ( 1 - offset );
+
+	if ( next.size() >= _k )
+	{
+		this->_compress ( level + 1 );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the approximate value at the given probability.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+double QuantileSketch::getQuantile ( double p ) const
+{
+	if ( 0 == _count )
+	{
+		throw std::runtime_error ( "Can not get a quantile of no values" );
+	}
+
+	if ( ( p < 0 ) || ( p > 1 ) )
+	{
+		throw std::out_of_range ( "Quantile probability must be in the range [0, 1]" );
+	}
+
+	// Gather the values and how much each one counts.
+	std::vector < std::pair < double, double > > weighted;
+	double total = 0;
+	for ( std::size_t i = 0; i < _levels.size(); ++i )
+	{
+		const double weight = static_cast < double > ( std::uint64_t ( 1 ) << i );
+		for ( const double value : _levels[i].values )
+		{
+			weighted.push_back ( std::make_pair ( value, weight ) );
+			total += weight;
+		}
+	}
+
+	std::sort ( weighted.begin(), weighted.end() );
+
+	// Find the first value where the running weight reaches the target.
+	const double target = p * total;
+	double sum = 0;
+	for ( const auto &item : weighted )
+	{
+		sum += item.second;
+		if ( sum >= target )
+		{
+			return item.first;
+		}
+	}
+
+	return weighted.back().first;
+}
@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Summary statistics that are built one value at a time and can be merged.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The count, mean, variance, and range of the values.
+//
+//	References:
+//	https://en.wikipedia.org/wiki/Algorithms_for_calculating_variance#Parallel_algorithm
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class RunningStats
+{
+public:
+
+	RunningStats();
+
+	// Add a value.
+	void add ( double );
+
+	// Add the other values to ours.
+	void merge ( const RunningStats & );
+
+	// Get the summary.
+	std::size_t getCount() const { return _count; }
+	double getMean() const { return _mean; }
+	double getVariance() const;
+	double getMin() const { return _min; }
+	double getMax() const { return _max; }
+
+private:
+
+	std::size_t _count;
+	double _mean;
+	double _m2;
+	double _min;
+	double _max;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	An approximate quantile sketch that uses a fixed amount of memory for
+//	each doubling of the number of values. Each level holds up to k values.
+//	When one is full it is sorted and every other value moves to the next
+//	level, where it counts twice as much. Which half moves alternates, so
+//	the answer only depends on the order the values and sketches are added.
+//
+//	References:
+//	https://arxiv.org/abs/1603.05346
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class QuantileSketch
+{
+public:
+
+	explicit QuantileSketch ( std::size_t k = 256 );
+
+	// Add a value.
+	void add ( double );
+
+	// Add the other values to ours.
+	void merge ( const QuantileSketch & );
+
+	// Get the number of values added.
+	std::size_t getCount() const { return _count; }
+
+	// Get the approximate value at the given probability in [0, 1].
+	double getQuantile ( double ) const;
+
+protected:
+
+	void _compress ( std::size_t level );
+
+private:
+
+	typedef std::vector < double > Values;
+
+	// The values of a level, and which half of them goes up next time.
+	struct Level
+	{
+		Values values;
+		std::size_t offset = 0;
+	};
+
+	std::size_t _k;
+	std::size_t _count;
+	std::vector < Level > _levels;
+};
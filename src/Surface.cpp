@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A height map that can answer many path distance queries.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Surface.h"
+#include "HeightMapDelta.h"
+#include "HeightMapFile.h"
+
+#include <sstream>
+#include <stdexcept>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Surface::Surface ( unsigned int numX, unsigned int numY, const std::string &input, bool lowMemory ) :
+	_numX ( numX ),
+	_numY ( numY ),
+	_input ( input ),
+	_container ( HeightMapFile::isHeightMapFile ( input ) ),
+	_lowMemory ( lowMemory ),
+	_corridor ( true ),
+	_horizontalResolution ( Terrain::DEFAULT_HORIZONTAL_RESOLUTION ),
+	_verticalResolution ( Terrain::DEFAULT_VERTICAL_RESOLUTION ),
+	_heights()
+{
+	if ( HeightMapDelta::isDeltaFile ( _input ) )
+	{
+		throw std::invalid_argument ( "Height map delta file " + _input + " needs a base height map" );
+	}
+
+	if ( _container )
+	{
+		// The file says what the size and resolution are.
+		HeightMapFile file ( _input );
+		const HeightMapFile::Header &header = file.getHeader();
+
+		if ( ( ( 0 != _numX ) || ( 0 != _numY ) ) && ( ( header.numX != _numX ) || ( header.numY != _numY ) ) )
+		{
+			std::ostringstream out;
+			out << "Given size " << _numX << " by " << _numY << " but height map file " << _input << " is " << header.numX << " by " << header.numY;
+			throw std::invalid_argument ( out.str() );
+		}
+
+		_numX = header.numX;
+		_numY = header.numY;
+		this->setResolution ( header.horizontalResolution, header.verticalResolution );
+
+		if ( !_lowMemory )
+		{
+			_heights = file.readAll();
+		}
+	}
+	else if ( _lowMemory )
+	{
+		// Just make sure we can read the file.
+		HeightGrid::open ( _numX, _numY, _input );
+	}
+	else
+	{
+		_heights = HeightGrid::read ( _numX, _numY, _input );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Surface::Surface ( unsigned int numX, unsigned int numY, HeightsView heights ) :
+	_numX ( numX ),
+	_numY ( numY ),
+	_input(),
+	_container ( false ),
+	_lowMemory ( false ),
+	_corridor ( true ),
+	_horizontalResolution ( Terrain::DEFAULT_HORIZONTAL_RESOLUTION ),
+	_verticalResolution ( Terrain::DEFAULT_VERTICAL_RESOLUTION ),
+	_heights ( numX, numY, heights )
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Surface::Surface ( const Surface &base, const std::string &deltaFile ) :
+	_numX ( base._numX ),
+	_numY ( base._numY ),
+	_input(),
+	_container ( false ),
+	_lowMemory ( base._lowMemory ),
+	_corridor ( base._corridor ),
+	_horizontalResolution ( base._horizontalResolution ),
+	_verticalResolution ( base._verticalResolution ),
+	_heights()
+{
+	HeightMapDelta delta ( deltaFile );
+	const HeightMapDelta::Header &header = delta.getHeader();
+
+	if ( ( header.numX != _numX ) || ( header.numY != _numY ) )
+	{
+		std::ostringstream out;
+		out << "Base size is " << _numX << " by " << _numY << " but height map delta file " << deltaFile << " is " << header.numX << " by " << header.numY;
+		throw std::invalid_argument ( out.str() );
+	}
+
+	// Use the base heights if it has them, otherwise read its file as we go.
+	_heights = ( base._heights.empty() ?
+		delta.apply ( base._input ) :
+		delta.apply ( base._heights )
+	);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Set the size of a cell and of one step in height.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Surface::setResolution ( double horizontal, double vertical )
+{
+	if ( !( horizontal > 0 ) || !( vertical > 0 ) )
+	{
+		std::ostringstream out;
+		out << "Resolution must be greater than zero, given horizontal = " << horizontal << " and vertical = " << vertical;
+		throw std::invalid_argument ( out.str() );
+	}
+
+	_horizontalResolution = horizontal;
+	_verticalResolution = vertical;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the terrain for the path. It either looks at our heights or reads
+//	them from our file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr < Terrain > Surface::_makeTerrain ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2 ) const
+{
+	std::unique_ptr < Terrain > terrain;
+
+	if ( !_heights.empty() )
+	{
+		terrain.reset ( new Terrain ( _numX, _numY, i1, j1, i2, j2, _heights.borrow() ) );
+	}
+	else if ( _container )
+	{
+		// The corridor only needs the tiles near the path. The whole mesh
+		// needs all of them.
+		HeightMapFile file ( _input );
+		if ( _corridor )
+		{
+			const HeightMapFile::Header &header = file.getHeader();
+			const double zMin = ( header.minHeight * _verticalResolution );
+			const double zMax = ( header.maxHeight * _verticalResolution );
+			const double margin = Terrain::getCorridorMargin ( i1, j1, i2, j2, zMin, zMax, _horizontalResolution );
+			terrain.reset ( new Terrain ( _numX, _numY, i1, j1, i2, j2, file.readNearPath ( i1, j1, i2, j2, margin ) ) );
+		}
+		else
+		{
+			terrain.reset ( new Terrain ( _numX, _numY, i1, j1, i2, j2, file.readAll() ) );
+		}
+	}
+	else
+	{
+		terrain.reset ( new Terrain ( _numX, _numY, i1, j1, i2, j2, _input ) );
+	}
+
+	terrain->setResolution ( _horizontalResolution, _verticalResolution );
+	terrain->setLowMemory ( _lowMemory );
+	terrain->setCorridor ( _corridor );
+	return terrain;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distance along the path.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+double Surface::getDistance ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2 ) const
+{
+	std::unique_ptr < Terrain > terrain = this->_makeTerrain ( i1, j1, i2, j2 );
+	return terrain->getDistance();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distance along the path in low-memory mode.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+double Surface::getDistance ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, StageMemory &stages ) const
+{
+	std::unique_ptr < Terrain > terrain = this->_makeTerrain ( i1, j1, i2, j2 );
+	terrain->setLowMemory ( true );
+	const double dist = terrain->getDistance();
+	stages = terrain->getStageMemory();
+	return dist;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distance, climb, descent, and slope along the path.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Surface::Metrics Surface::getMetrics ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2 ) const
+{
+	std::unique_ptr < Terrain > terrain = this->_makeTerrain ( i1, j1, i2, j2 );
+	return terrain->getMetrics();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the metrics along the path in low-memory mode.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Surface::Metrics Surface::getMetrics ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, StageMemory &stages ) const
+{
+	std::unique_ptr < Terrain > terrain = this->_makeTerrain ( i1, j1, i2, j2 );
+	terrain->setLowMemory ( true );
+	const Metrics metrics = terrain->getMetrics();
+	stages = terrain->getStageMemory();
+	return metrics;
+}
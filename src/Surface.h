@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A height map that can answer many path distance queries.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Terrain.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The surface holds the heights and makes a Terrain for each query.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+class Surface
+{
+public:
+
+	typedef Terrain::Heights Heights;
+	typedef Terrain::HeightsView HeightsView;
+	typedef Terrain::StageMemory StageMemory;
+	typedef Terrain::Metrics Metrics;
+
+	// Construct from a file of heights. The heights are read now, unless
+	// in low-memory mode, where each query reads them from the file. The
+	// file is either raw heights or a HeightMapFile. For the latter the
+	// size can be zero, which means use the size in the file.
+	Surface ( unsigned int numX, unsigned int numY, const std::string &input, bool lowMemory = false );
+
+	// Construct from heights owned by the caller. They are not copied,
+	// so they have to outlive this object.
+	Surface ( unsigned int numX, unsigned int numY, HeightsView heights );
+
+	// Construct from the base surface and a HeightMapDelta file of the
+	// changes to it. The heights after the changes are kept, and the base
+	// can go away.
+	Surface ( const Surface &base, const std::string &deltaFile );
+
+	// The default destructor is fine.
+	~Surface() = default;
+
+	// Not copyable or movable.
+	Surface ( const Surface & ) = delete;
+	Surface ( Surface && ) = delete;
+	Surface & operator = ( const Surface & ) = delete;
+	Surface & operator = ( Surface && ) = delete;
+
+	// Get the size.
+	unsigned int getNumX() const { return _numX; }
+	unsigned int getNumY() const { return _numY; }
+
+	// Set the size of a cell and of one step in height, in meters.
+	double getHorizontalResolution() const { return _horizontalResolution; }
+	double getVerticalResolution() const { return _verticalResolution; }
+	void setResolution ( double horizontal, double vertical );
+
+	// Get the distance along the path.
+	double getDistance ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2 ) const;
+
+	// Get the distance along the path in low-memory mode, and the peak
+	// memory of each stage.
+	double getDistance ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, StageMemory &stages ) const;
+
+	// Get the distance, climb, descent, and slope along the path.
+	Metrics getMetrics ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2 ) const;
+
+	// Get the metrics along the path in low-memory mode, and the peak
+	// memory of each stage.
+	Metrics getMetrics ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, StageMemory &stages ) const;
+
+	// Is this surface in low-memory mode?
+	bool getLowMemory() const { return _lowMemory; }
+
+	// Set the corridor mode of the queries. See Terrain::setCorridor().
+	bool getCorridor() const { return _corridor; }
+	void setCorridor ( bool state ) { _corridor = state; }
+
+protected:
+
+	std::unique_ptr < Terrain > _makeTerrain ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2 ) const;
+
+private:
+
+	unsigned int _numX;
+	unsigned int _numY;
+	std::string _input;
+	bool _container;
+	bool _lowMemory;
+	bool _corridor;
+	double _horizontalResolution;
+	double _verticalResolution;
+	HeightGrid _heights;
+};
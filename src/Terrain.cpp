@@ -14,12 +14,17 @@
 #include "CGAL/AABB_traits.h"
 #include "CGAL/AABB_triangle_primitive.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 #if 0
 #ifdef _DEBUG
@@ -28,16 +33,6 @@
 #endif
 
 
-////////////////////////////////////////////////////////////////////////////////
-//
-//	Constants used below.
-//
-////////////////////////////////////////////////////////////////////////////////
-
-const double HORIZONTAL_RESOLUTION = 30;
-const double VERTICAL_RESOLUTION = 11;
-
-
 ////////////////////////////////////////////////////////////////////////////////
 //
 //	Constructor.
@@ -59,22 +54,27 @@ Terrain::Terrain (
 	_j1 ( j1 ),
 	_i2 ( i2 ),
 	_j2 ( j2 ),
+	_input ( input ),
+	_lowMemory ( false ),
+	_corridor ( true ),
+	_horizontalResolution ( DEFAULT_HORIZONTAL_RESOLUTION ),
+	_verticalResolution ( DEFAULT_VERTICAL_RESOLUTION ),
 	_heights(),
+	_columns(),
 	_points(),
 	_triangles(),
 	_plane(),
+	_start(),
+	_end(),
 	_lines(),
-	_dist ( -1 )
+	_dist ( -1 ),
+	_metrics(),
+	_hasMetrics ( false ),
+	_stageMemory(),
+	_stagePeak ( 0 )
 {
 #ifdef USE_FAKE_DATA
 
-	_heights = {
-		1, 1, 1, 1,
-		1, 1, 1, 1,
-		1, 1, 1, 1,
-		1, 1, 1, 1,
-	};
-
 	_numX = 4;
 	_numY = 4;
 	_i1 = 1;
@@ -82,8 +82,127 @@ Terrain::Terrain (
 	_i2 = 3;
 	_j2 = 3;
 
+	_heights = HeightGrid ( _numX, _numY, Heights {
+		1, 1, 1, 1,
+		1, 1, 1, 1,
+		1, 1, 1, 1,
+		1, 1, 1, 1,
+	} );
+
 #else // Use real data.
 
+	// Make sure the input makes sense.
+	this->_checkInput();
+
+	// Make sure we can read the file. The heights are read when we find
+	// the path, so that low-memory mode can stream them instead.
+	HeightGrid::open ( _numX, _numY, _input );
+
+#endif // Use real data.
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Terrain::Terrain (
+	unsigned int numX,
+	unsigned int numY,
+	unsigned int i1,
+	unsigned int j1,
+	unsigned int i2,
+	unsigned int j2,
+	HeightsView heights
+) :
+	Terrain ( numX, numY, i1, j1, i2, j2, HeightGrid ( numX, numY, heights ) )
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Terrain::Terrain (
+	unsigned int numX,
+	unsigned int numY,
+	unsigned int i1,
+	unsigned int j1,
+	unsigned int i2,
+	unsigned int j2,
+	Heights &&heights
+) :
+	Terrain ( numX, numY, i1, j1, i2, j2, HeightGrid ( numX, numY, std::move ( heights ) ) )
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Constructor.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Terrain::Terrain (
+	unsigned int numX,
+	unsigned int numY,
+	unsigned int i1,
+	unsigned int j1,
+	unsigned int i2,
+	unsigned int j2,
+	HeightGrid &&heights
+) :
+	_numX ( numX ),
+	_numY ( numY ),
+	_i1 ( i1 ),
+	_j1 ( j1 ),
+	_i2 ( i2 ),
+	_j2 ( j2 ),
+	_input(),
+	_lowMemory ( false ),
+	_corridor ( true ),
+	_horizontalResolution ( DEFAULT_HORIZONTAL_RESOLUTION ),
+	_verticalResolution ( DEFAULT_VERTICAL_RESOLUTION ),
+	_heights ( std::move ( heights ) ),
+	_columns(),
+	_points(),
+	_triangles(),
+	_plane(),
+	_start(),
+	_end(),
+	_lines(),
+	_dist ( -1 ),
+	_metrics(),
+	_hasMetrics ( false ),
+	_stageMemory(),
+	_stagePeak ( 0 )
+{
+	// Make sure the input makes sense.
+	this->_checkInput();
+
+	// Make sure the grid is the same size.
+	if ( ( _heights.getNumX() != _numX ) || ( _heights.getNumY() != _numY ) )
+	{
+		std::ostringstream out;
+		out << "Given " << _heights.getNumX() << " by " << _heights.getNumY() << " heights but expected " << _numX << " by " << _numY;
+		throw std::invalid_argument ( out.str() );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Check the size and the path indices.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Terrain::_checkInput() const
+{
 	// Check the size.
 	if ( ( _numX < 2 ) || ( _numY < 2 ) )
 	{
@@ -96,43 +215,142 @@ Terrain::Terrain (
 		throw std::invalid_argument ( "Path start and end points are the same" );
 	}
 
-	// Make sure the indices are within range.
-	if ( ( _i1 >= _numX ) || ( _i2 >= _numX ) )
+	// Make sure the indices are within range. The i indices are rows and
+	// the j indices are columns, just like in _getIndex().
+	if ( ( _i1 >= _numY ) || ( _i2 >= _numY ) || ( _j1 >= _numX ) || ( _j2 >= _numX ) )
 	{
 		throw std::out_of_range ( "Given indices are greater than the size" );
 	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the start and end of the path.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Terrain::Vec2ui Terrain::getPathStart() const
+{
+	return Vec2ui ( _i1, _j1 );
+}
+Terrain::Vec2ui Terrain::getPathEnd() const
+{
+	return Vec2ui ( _i2, _j2 );
+}
+
 
-	// Open the input file in binary.
-	std::ifstream in ( input.c_str(), std::ios::binary );
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Set the size of a cell and of one step in height.
+//
+////////////////////////////////////////////////////////////////////////////////
 
-	// Did it open?
-	if ( !in.is_open() )
+void Terrain::setResolution ( double horizontal, double vertical )
+{
+	if ( !( horizontal > 0 ) || !( vertical > 0 ) )
 	{
 		std::ostringstream out;
-		out << "Could not open input file: " << input;
-		throw std::runtime_error ( out.str() );
+		out << "Resolution must be greater than zero, given horizontal = " << horizontal << " and vertical = " << vertical;
+		throw std::invalid_argument ( out.str() );
 	}
 
-	// Read the file into a vector of data.
-	this->_readHeightData ( in );
+	_horizontalResolution = horizontal;
+	_verticalResolution = vertical;
+}
 
-#endif // Use real data.
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Set the low-memory mode.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Terrain::setLowMemory ( bool state )
+{
+	_lowMemory = state;
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-//	Get the start and end of the path.
+//	Set the corridor mode.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-Terrain::Vec2ui Terrain::getPathStart() const
+void Terrain::setCorridor ( bool state )
 {
-	return Vec2ui ( _i1, _j1 );
+	_corridor = state;
 }
-Terrain::Vec2ui Terrain::getPathEnd() const
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the name of the stage.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+const char *Terrain::getStageName ( Stage stage )
 {
-	return Vec2ui ( _i2, _j2 );
+	switch ( stage )
+	{
+		case STAGE_POINTS:    return "points";
+		case STAGE_TRIANGLES: return "triangles";
+		case STAGE_INTERSECT: return "intersect";
+		case STAGE_DISTANCE:  return "distance";
+		default:              return "unknown";
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the bytes held by the heights, points, triangles, and lines.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::size_t Terrain::_getOwnedBytes() const
+{
+	return (
+		_heights.getOwnedBytes() +
+		( _columns.capacity() * sizeof ( ColumnRanges::value_type ) ) +
+		( _points.capacity() * sizeof ( Point ) ) +
+		( _triangles.capacity() * sizeof ( Triangle ) ) +
+		( _lines.capacity() * sizeof ( LineSegment ) ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Note what we hold now, plus the given bytes of local buffers, in the
+//	peak of the current stage.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Terrain::_noteMemory ( std::size_t extra )
+{
+	if ( _lowMemory )
+	{
+		_stagePeak = std::max ( _stagePeak, ( this->_getOwnedBytes() + extra ) );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Record the peak memory of the stage that just finished. The next stage
+//	starts with what this one left behind.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Terrain::_recordStage ( Stage stage )
+{
+	if ( _lowMemory )
+	{
+		this->_noteMemory ( 0 );
+		_stageMemory[stage] = _stagePeak;
+		_stagePeak = this->_getOwnedBytes();
+	}
 }
 
 
@@ -144,27 +362,76 @@ Terrain::Vec2ui Terrain::getPathEnd() const
 
 void Terrain::_findPath()
 {
-	// Make the ground points with real coordinates.
-	this->_makeGroundPoints();
+	// In low-memory mode the peak of the first stage starts here.
+	if ( _lowMemory )
+	{
+		_stageMemory.fill ( 0 );
+		_stagePeak = this->_getOwnedBytes();
+	}
 
-	// Make the triangles.
-	this->_makeTriangles();
+	// Read the heights now unless low-memory mode is going to stream them.
+	if ( _heights.empty() && !_lowMemory )
+	{
+		_heights = HeightGrid::read ( _numX, _numY, _input );
+	}
 
-	// Make the plane.
+	// Make the plane. This also saves the end points of the path.
 	this->_makePlane();
 
+	// Make the ground points with real coordinates, only in the corridor
+	// around the path when we can.
+	if ( _corridor )
+	{
+		this->_makeCorridor();
+		this->_makeCorridorPoints();
+	}
+	else
+	{
+		this->_makeGroundPoints();
+	}
+
+	// The heights are all in the points now.
+	this->_noteMemory ( 0 );
+	if ( _lowMemory )
+	{
+		_heights = HeightGrid();
+	}
+	this->_recordStage ( STAGE_POINTS );
+
+	// Make the triangles.
+	if ( _corridor )
+	{
+		this->_makeCorridorTriangles();
+	}
+	else
+	{
+		this->_makeTriangles();
+	}
+
+	// The points are all in the triangles now.
+	this->_noteMemory ( 0 );
+	if ( _lowMemory )
+	{
+		_points = Points();
+		_columns = ColumnRanges();
+	}
+	this->_recordStage ( STAGE_TRIANGLES );
+
 	// Intersect the plane with the triangles.
 	this->_intersect();
+	this->_recordStage ( STAGE_INTERSECT );
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
 //
 //	Given an i and j position in the grid, return the index in the 1D array.
+//	The index type has to hold the number of cells. Mid-sized grids use
+//	32-bit indices, and larger ones use 64-bit indices.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-unsigned int Terrain::_getIndex ( unsigned int i, unsigned int j ) const
+template < class IndexType > IndexType Terrain::_getIndex ( unsigned int i, unsigned int j ) const
 {
 	// Make sure the indices are in range.
 	if ( ( i >= _numY ) || ( j >= _numX ) )
@@ -175,10 +442,10 @@ unsigned int Terrain::_getIndex ( unsigned int i, unsigned int j ) const
 	}
 
 	// Calculate the answer.
-	const unsigned int answer = ( i * _numX + j );
+	const IndexType answer = ( static_cast < IndexType > ( i ) * _numX + j );
 
 	// Make sure it is in range.
-	if ( answer >= ( _numX * _numY ) )
+	if ( answer >= this->_getNumCells() )
 	{
 		std::ostringstream out;
 		out << "Calculated index " << answer << " is out of range for numX = " << _numX << " and numY = " << _numY;
@@ -192,72 +459,386 @@ unsigned int Terrain::_getIndex ( unsigned int i, unsigned int j ) const
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-//	Read the heights from the input file.
+//	Get the number of cells in the grid.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-void Terrain::_readHeightData ( std::ifstream &in )
+Terrain::Index Terrain::_getNumCells() const
 {
-	// Make the container of heights and size it correctly.
-	Heights heights;
-	heights.resize ( _numX * _numY );
+	return ( static_cast < Index > ( _numX ) * _numY );
+}
 
-	// The size of all the data in bytes.
-	const std::size_t dataSize = heights.size() * ( sizeof ( Heights::value_type ) );
 
-	// Read all the values into the container.
-	in.read ( reinterpret_cast < char * > ( &heights[0] ), dataSize );
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the ground points with real coordinates.
+//	Note: CoPilot initially wrote this whole function. I changed very little.
+//
+////////////////////////////////////////////////////////////////////////////////
 
-	// Make sure it all read correctly.
-	if ( ( static_cast < std::streamsize > ( dataSize ) ) != in.gcount() )
+void Terrain::_makeGroundPoints()
+{
+	// In low-memory mode we may not have the heights, so we read them from
+	// the file one row at a time.
+	const bool streaming = _heights.empty();
+
+	// Open the file if we are streaming.
+	std::ifstream in;
+	Heights buffer;
+	if ( streaming )
+	{
+		in = HeightGrid::open ( _numX, _numY, _input );
+		buffer.resize ( _numX );
+	}
+
+	// Make the container of points and save space.
+	Points points;
+	points.reserve ( static_cast < std::size_t > ( this->_getNumCells() ) );
+
+	// Loop over the heights and make the points.
+	for ( unsigned int i = 0; i < _numY; ++i )
+	{
+		// Read the next row if we have to.
+		if ( streaming )
+		{
+			in.read ( reinterpret_cast < char * > ( &buffer[0] ), buffer.size() );
+			if ( ( static_cast < std::streamsize > ( buffer.size() ) ) != in.gcount() )
+			{
+				std::ostringstream out;
+				out << "Read " << in.gcount() << " bytes of row " << i << " but expected " << buffer.size();
+				throw std::runtime_error ( out.str() );
+			}
+		}
+
+		// The rows are whole in both cases.
+		const HeightsView row = ( streaming ? HeightsView ( buffer ) : _heights.getRow ( i ) );
+
+		for ( unsigned int j = 0; j < _numX; ++j )
+		{
+			points.push_back ( this->_makePoint ( i, j, row[j] ) );
+		}
+	}
+
+	// Set the points. Moving does not hold two copies.
+	_points = std::move ( points );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the point with real coordinates at the i and j position.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Terrain::Point Terrain::_makePoint ( unsigned int i, unsigned int j, Heights::value_type height ) const
+{
+	return Point (
+		( static_cast < double > ( j ) * _horizontalResolution ),
+		( static_cast < double > ( i ) * _horizontalResolution ),
+		( static_cast < double > ( height ) * _verticalResolution )
+	);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Read some of the heights in the row from the file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Terrain::_readRow ( std::ifstream &in, unsigned int i, unsigned int first, Heights &heights ) const
+{
+	in.seekg ( static_cast < std::streamoff > ( this->_getIndex < Index > ( i, first ) ) );
+	in.read ( reinterpret_cast < char * > ( &heights[0] ), heights.size() );
+	if ( ( static_cast < std::streamsize > ( heights.size() ) ) != in.gcount() )
 	{
 		std::ostringstream out;
-		out << "Read " << in.gcount() << " bytes but expected " << dataSize;
+		out << "Read " << in.gcount() << " bytes of row " << i << " but expected " << heights.size();
 		throw std::runtime_error ( out.str() );
 	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the height at the i and j position, from the file if we have to.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+Terrain::Heights::value_type Terrain::_getHeight ( unsigned int i, unsigned int j ) const
+{
+	// Make sure the indices are in range.
+	this->_getIndex < Index > ( i, j );
+
+	if ( !_heights.empty() )
+	{
+		return _heights.getRow ( i, j, 1 )[0];
+	}
 
-	// Set the heights. This should be a move-copy so not expensive.
-	_heights = heights;
+	std::ifstream in = HeightGrid::open ( _numX, _numY, _input );
+	Heights height ( 1 );
+	this->_readRow ( in, i, j, height );
+	return height[0];
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-//	Make the ground points with real coordinates.
-//	Note: CoPilot initially wrote this whole function. I changed very little.
+//	Get the lowest and highest ground. Without the heights we use the whole
+//	range of the height type.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-void Terrain::_makeGroundPoints()
+void Terrain::_getHeightRange ( double &zMin, double &zMax ) const
 {
-	// Make sure the sizes match.
-	if ( _heights.size() != ( _numX * _numY ) )
+	Heights::value_type lowest = std::numeric_limits < Heights::value_type >::min();
+	Heights::value_type highest = std::numeric_limits < Heights::value_type >::max();
+
+	if ( !_heights.empty() )
 	{
-		std::ostringstream out;
-		out << "Heights size is " << _heights.size() << " but expected " << ( _numX * _numY );
-		throw std::invalid_argument ( out.str() );
+		lowest = _heights.getMinHeight();
+		highest = _heights.getMaxHeight();
 	}
 
-	// Make the container of points and save space.
+	zMin = ( static_cast < double > ( lowest ) * _verticalResolution );
+	zMax = ( static_cast < double > ( highest ) * _verticalResolution );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Find the cells that could be part of the path.
+//
+//	A line segment is kept when its midpoint is between the two end planes
+//	in _intersect(). Those planes lean with the path, so the midpoint can be
+//	past the end of the path when the ground there is high or low enough.
+//	Going from [i1,j1] at t = 0 to [i2,j2] at t = 1, a midpoint at height z
+//	is kept when
+//
+//	  t * L^2 + ( z - z1 ) * dz > 0  and  ( t - 1 ) * L^2 + ( z - z2 ) * dz < 0
+//
+//	where L is the horizontal length of the path and dz is its rise. With z
+//	anywhere from the lowest to the highest ground, that bounds t. The
+//	midpoint is in the cell of the triangle it came from, so the corridor
+//	is the cells under the path from the lowest to the highest t, and one
+//	more cell all around so that rounding can not leave any out.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Terrain::_makeCorridor()
+{
+	// The path in real coordinates.
+	const double dx = ( _end[0] - _start[0] );
+	const double dy = ( _end[1] - _start[1] );
+	const double dz = ( _end[2] - _start[2] );
+	const double length2 = ( ( dx * dx ) + ( dy * dy ) );
+
+	// How far past each end the path can go.
+	double zMin = 0, zMax = 0;
+	this->_getHeightRange ( zMin, zMax );
+	const double tMin = ( -std::max ( ( ( zMax - _start[2] ) * dz ), ( ( zMin - _start[2] ) * dz ) ) / length2 );
+	const double tMax = ( 1 - ( std::min ( ( ( zMin - _end[2] ) * dz ), ( ( zMax - _end[2] ) * dz ) ) / length2 ) );
+
+	// The path in grid indices.
+	const double di = ( static_cast < double > ( _i2 ) - _i1 );
+	const double dj = ( static_cast < double > ( _j2 ) - _j1 );
+	const double pad = 1;
+
+	// Start with all the rows empty.
+	ColumnRanges columns ( ( _numY - 1 ), std::make_pair ( 1u, 0u ) );
+
+	// Loop over the rows of cells.
+	for ( unsigned int r = 0; r < ( _numY - 1 ); ++r )
+	{
+		// The rows this row of cells covers.
+		const double rowA = ( static_cast < double > ( r ) - pad );
+		const double rowB = ( static_cast < double > ( r ) + 1 + pad );
+
+		// The part of the path over them.
+		double t0 = tMin;
+		double t1 = tMax;
+		if ( 0 != di )
+		{
+			double ta = ( ( rowA - _i1 ) / di );
+			double tb = ( ( rowB - _i1 ) / di );
+			if ( ta > tb )
+			{
+				std::swap ( ta, tb );
+			}
+			t0 = std::max ( t0, ta );
+			t1 = std::min ( t1, tb );
+		}
+		else if ( ( _i1 < rowA ) || ( _i1 > rowB ) )
+		{
+			continue;
+		}
+		if ( t0 > t1 )
+		{
+			continue;
+		}
+
+		// The columns of cells under that part.
+		const double jA = ( _j1 + ( t0 * dj ) );
+		const double jB = ( _j1 + ( t1 * dj ) );
+		const double first = std::max ( ( std::floor ( std::min ( jA, jB ) ) - pad ), 0.0 );
+		const double last = std::min ( ( std::floor ( std::max ( jA, jB ) ) + pad ), static_cast < double > ( _numX - 2 ) );
+		if ( first > last )
+		{
+			continue;
+		}
+
+		columns[r] = std::make_pair ( static_cast < unsigned int > ( first ), static_cast < unsigned int > ( last ) );
+	}
+
+	// Set the corridor.
+	_columns = std::move ( columns );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get how far from the path the corridor can reach. This bounds what
+//	_makeCorridor() does without knowing the heights at the ends of the
+//	path. The rise of the path is at most zMax - zMin, so the path can go
+//	past each end by t = ( zMax - zMin )^2 / L^2. The padding and rounding
+//	there add less than three cells, and we add one more.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+double Terrain::getCorridorMargin ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double zMin, double zMax, double horizontalResolution )
+{
+	const double di = ( static_cast < double > ( i2 ) - i1 );
+	const double dj = ( static_cast < double > ( j2 ) - j1 );
+	const double cells = std::sqrt ( ( di * di ) + ( dj * dj ) );
+	if ( !( cells > 0 ) || !( horizontalResolution > 0 ) )
+	{
+		return std::numeric_limits < double >::infinity();
+	}
+
+	const double length = ( cells * horizontalResolution );
+	const double rise = ( zMax - zMin );
+	return ( ( ( rise * rise ) / ( length * length ) ) * cells ) + 4;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the ground points in the corridor. For each row of cells there are
+//	the points on the row above them and then the points on the row below.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Terrain::_makeCorridorPoints()
+{
+	// In low-memory mode we may not have the heights, so we read the parts
+	// of the rows we need from the file.
+	const bool streaming = _heights.empty();
+
+	// Open the file if we are streaming.
+	std::ifstream in;
+	Heights buffer;
+	if ( streaming )
+	{
+		in = HeightGrid::open ( _numX, _numY, _input );
+	}
+
+	// Count the points so that we can save space.
+	std::size_t numPoints = 0;
+	for ( const auto &range : _columns )
+	{
+		if ( range.first <= range.second )
+		{
+			numPoints += 2 * ( static_cast < std::size_t > ( range.second - range.first ) + 2 );
+		}
+	}
 	Points points;
-	points.reserve ( _numX * _numY );
+	points.reserve ( numPoints );
 
-	// Loop over the heights and make the points.
-	for ( unsigned int i = 0; i < _numY; ++i )
+	// Loop over the rows of cells.
+	for ( unsigned int r = 0; r < _columns.size(); ++r )
 	{
-		for ( unsigned int j = 0; j < _numX; ++j )
+		const auto &range = _columns[r];
+		if ( range.first > range.second )
 		{
-			const unsigned int index = this->_getIndex ( i, j );
-			points.push_back ( Point (
-				( static_cast < double > ( j ) * HORIZONTAL_RESOLUTION ),
-				( static_cast < double > ( i ) * HORIZONTAL_RESOLUTION ),
-				( static_cast < double > ( _heights.at ( index ) ) * VERTICAL_RESOLUTION )
-			) );
+			continue;
+		}
+
+		// The points on both sides of the cells.
+		const unsigned int count = ( range.second - range.first + 2 );
+		for ( unsigned int i = r; i <= ( r + 1 ); ++i )
+		{
+			HeightsView row;
+			if ( streaming )
+			{
+				buffer.resize ( count );
+				this->_readRow ( in, i, range.first, buffer );
+				row = HeightsView ( buffer );
+			}
+			else
+			{
+				row = _heights.getRow ( i, range.first, count );
+			}
+
+			for ( unsigned int k = 0; k < count; ++k )
+			{
+				points.push_back ( this->_makePoint ( i, range.first + k, row[k] ) );
+			}
 		}
 	}
 
-	// Set the points. This should be a move-copy.
-	_points = points;
+	// Set the points. Moving does not hold two copies.
+	_points = std::move ( points );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Make the triangles in the corridor. They are the same triangles in the
+//	same order as the whole mesh, just without the ones outside.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void Terrain::_makeCorridorTriangles()
+{
+	// Make the container of triangles and give it space.
+	Triangles triangles;
+	triangles.reserve ( _points.size() );
+
+	// Loop over the rows of cells.
+	std::size_t start = 0;
+	for ( const auto &range : _columns )
+	{
+		if ( range.first > range.second )
+		{
+			continue;
+		}
+
+		// Make sure the points are there.
+		const std::size_t count = ( static_cast < std::size_t > ( range.second - range.first ) + 2 );
+		if ( ( start + ( 2 * count ) ) > _points.size() )
+		{
+			std::ostringstream out;
+			out << "Points size is " << _points.size() << " but the corridor needs more";
+			throw std::invalid_argument ( out.str() );
+		}
+
+		// Add two triangles for each cell.
+		for ( std::size_t k = 0; ( k + 1 ) < count; ++k )
+		{
+			const Point &tl = _points[start + k]; // Top left.
+			const Point &tr = _points[start + k + 1];
+			const Point &bl = _points[start + count + k];
+			const Point &br = _points[start + count + k + 1];
+
+			triangles.push_back ( Triangle ( tl, bl, tr ) );
+			triangles.push_back ( Triangle ( br, tr, bl ) );
+		}
+
+		start += ( 2 * count );
+	}
+
+	// Set the triangles. Moving does not hold two copies.
+	_triangles = std::move ( triangles );
 }
 
 
@@ -270,28 +851,48 @@ void Terrain::_makeGroundPoints()
 void Terrain::_makeTriangles()
 {
 	// Make sure the sizes match.
-	if ( _points.size() != ( _numX * _numY ) )
+	if ( _points.size() != this->_getNumCells() )
 	{
 		std::ostringstream out;
-		out << "Points size is " << _points.size() << " but expected " << ( _numX * _numY );
+		out << "Points size is " << _points.size() << " but expected " << this->_getNumCells();
 		throw std::invalid_argument ( out.str() );
 	}
 
 	// Make the container of triangles and give it space.
 	Triangles triangles;
-	triangles.reserve ( ( _numX - 1 ) * ( _numY - 1 ) * 2 );
+	triangles.reserve ( static_cast < std::size_t > ( _numX - 1 ) * ( _numY - 1 ) * 2 );
+
+	// Use 32-bit indices when they can hold the number of cells.
+	if ( this->_getNumCells() <= std::numeric_limits < std::uint32_t >::max() )
+	{
+		this->_addTriangleRows < std::uint32_t > ( triangles );
+	}
+	else
+	{
+		this->_addTriangleRows < Index > ( triangles );
+	}
 
+	// Set the triangles. Moving does not hold two copies.
+	_triangles = std::move ( triangles );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Add all the rows of triangles.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+template < class IndexType > void Terrain::_addTriangleRows ( Triangles &triangles ) const
+{
 	// Make the first row.
-	this->_addTriangleRow ( 0, 1, triangles );
+	this->_addTriangleRow < IndexType > ( 0, 1, triangles );
 
 	// Loop over the remaining rows.
 	for ( unsigned int i = 1; i < ( _numY - 1 ); ++i )
 	{
-		this->_addTriangleRow ( i, i + 1, triangles );
+		this->_addTriangleRow < IndexType > ( i, i + 1, triangles );
 	}
-
-	// Set the triangles. This should be a move-copy.
-	_triangles = triangles;
 }
 
 
@@ -301,7 +902,7 @@ void Terrain::_makeTriangles()
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-void Terrain::_addTriangleRow ( unsigned int rowA, unsigned int rowB, Triangles &triangles ) const
+template < class IndexType > void Terrain::_addTriangleRow ( unsigned int rowA, unsigned int rowB, Triangles &triangles ) const
 {
 	// Make sure the indices are within range.
 	if ( ( rowA >= _numY ) || ( rowB >= _numY ) )
@@ -312,12 +913,12 @@ void Terrain::_addTriangleRow ( unsigned int rowA, unsigned int rowB, Triangles
 	}
 
 	// Make the first column.
-	this->_addTwoTriangles ( rowA, rowB, 0, 1, triangles );
+	this->_addTwoTriangles < IndexType > ( rowA, rowB, 0, 1, triangles );
 
 	// Loop over the remaining columns.
 	for ( unsigned int j = 1; j < ( _numX - 1 ); ++j )
 	{
-		this->_addTwoTriangles ( rowA, rowB, j, j + 1, triangles );
+		this->_addTwoTriangles < IndexType > ( rowA, rowB, j, j + 1, triangles );
 	}
 }
 
@@ -328,7 +929,7 @@ void Terrain::_addTriangleRow ( unsigned int rowA, unsigned int rowB, Triangles
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-void Terrain::_addTwoTriangles ( unsigned int rowA, unsigned int rowB, unsigned int colA, unsigned int colB, Triangles &triangles ) const
+template < class IndexType > void Terrain::_addTwoTriangles ( unsigned int rowA, unsigned int rowB, unsigned int colA, unsigned int colB, Triangles &triangles ) const
 {
 	// Make sure the indices are within range.
 	if ( ( colB >= _numX ) || ( colA >= _numX ) )
@@ -345,10 +946,10 @@ void Terrain::_addTwoTriangles ( unsigned int rowA, unsigned int rowB, unsigned
 	}
 
 	// Get the 1D indices.
-	const unsigned int itl = this->_getIndex ( rowA, colA ); // Index, top left.
-	const unsigned int itr = this->_getIndex ( rowA, colB );
-	const unsigned int ibl = this->_getIndex ( rowB, colA );
-	const unsigned int ibr = this->_getIndex ( rowB, colB );
+	const IndexType itl = this->_getIndex < IndexType > ( rowA, colA ); // Index, top left.
+	const IndexType itr = this->_getIndex < IndexType > ( rowA, colB );
+	const IndexType ibl = this->_getIndex < IndexType > ( rowB, colA );
+	const IndexType ibr = this->_getIndex < IndexType > ( rowB, colB );
 
 	// Get the points.
 	const Point &tl = _points.at ( itl ); // Top left.
@@ -372,13 +973,13 @@ void Terrain::_addTwoTriangles ( unsigned int rowA, unsigned int rowB, unsigned
 void Terrain::_makePlane()
 {
 	// Get the 3D points at the given indices.
-	const Point &p1 = _points.at ( this->_getIndex ( _i1, _j1 ) );
-	const Point &p2 = _points.at ( this->_getIndex ( _i2, _j2 ) );
+	const Point p1 = this->_makePoint ( _i1, _j1, this->_getHeight ( _i1, _j1 ) );
+	const Point p2 = this->_makePoint ( _i2, _j2, this->_getHeight ( _i2, _j2 ) );
 
 	// Make sure they are not the same point.
 	if ( p1 == p2 )
 	{
-		throw std::invalid_argument ( "Input points are equal when calculating plane" );
+		throw GeometryError ( "Input points are equal when calculating plane" );
 	}
 
 	// Get the 2D line from p1 to p2.
@@ -394,7 +995,7 @@ void Terrain::_makePlane()
 	// Check the length.
 	if ( 0 == n.norm() ) // TODO: Should use a "close float" tolerance.
 	{
-		throw std::runtime_error ( "Plane normal vector length is zero" );
+		throw GeometryError ( "Plane normal vector length is zero" );
 	}
 
 	// Normalize the normal vector.
@@ -403,7 +1004,7 @@ void Terrain::_makePlane()
 	// Check the normal coefficients.
 	if ( ( n[0] == 0.0 ) && ( n[1] == 0.0 ) && ( n[2] == 0.0 ) )
 	{
-		throw std::runtime_error ( "Plane normal vector is all zeros" );
+		throw GeometryError ( "Plane normal vector is all zeros" );
 	}
 
 	// Get the plane from the point and normal.
@@ -411,6 +1012,10 @@ void Terrain::_makePlane()
 
 	// Set the new plane.
 	_plane = plane;
+
+	// Save the end points because the other points may be freed.
+	_start = p1;
+	_end = p2;
 }
 
 
@@ -439,9 +1044,40 @@ namespace { namespace Details
 			makeMapKey ( s1, s0 )
 		);
 	};
+	inline std::array < double, 6 > getSortedEnds ( const Terrain::LineSegment &line )
+	{
+		const std::array < double, 3 > a = { line[0][0], line[0][1], line[0][2] };
+		const std::array < double, 3 > b = { line[1][0], line[1][1], line[1][2] };
+		const std::array < double, 3 > &lo = std::min ( a, b );
+		const std::array < double, 3 > &hi = std::max ( a, b );
+		return { lo[0], lo[1], lo[2], hi[0], hi[1], hi[2] };
+	}
+	inline bool isLess ( const Terrain::LineSegment &a, const Terrain::LineSegment &b )
+	{
+		return ( getSortedEnds ( a ) < getSortedEnds ( b ) );
+	}
 } }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Add the line segment to the map. The keys are rounded, so two different
+//	line segments can make the same key. Keeping the lesser one makes the
+//	answer the same whatever order the hits come in.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+std::pair < Terrain::LineSegmentMap::iterator, bool > Terrain::addLineSegment ( const LineSegment &line, LineSegmentMap &lsm )
+{
+	const std::pair < LineSegmentMap::iterator, bool > result = lsm.insert ( std::make_pair ( Details::makeMapKey ( line ), line ) );
+	if ( ( !result.second ) && Details::isLess ( line, result.first->second ) )
+	{
+		result.first->second = line;
+	}
+	return result;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //	Intersect the plane with the triangles.
@@ -459,19 +1095,33 @@ void Terrain::_intersect()
 	typedef boost::optional < IntersectionType > IntersectionData;
 	typedef Kernel::Vector_3 Vector;
 
-	// Make the AABB tree.
-	Tree tree ( _triangles.begin(), _triangles.end() );
-
 	// This is where the line-segments get added to.
 	std::vector < IntersectionData > hits;
 
-	// Intersect the triangles with the plane using the AABB tree.
-	tree.all_intersections ( _plane, std::back_inserter ( hits ) );
+	// The tree is only needed for the intersection.
+	{
+		// Make the AABB tree.
+		Tree tree ( _triangles.begin(), _triangles.end() );
+
+		// Intersect the triangles with the plane using the AABB tree.
+		tree.all_intersections ( _plane, std::back_inserter ( hits ) );
+
+		// CGAL does not say what the tree holds. It has a primitive for each
+		// triangle and about as many nodes, each a box and two children.
+		const std::size_t treeBytes = ( _triangles.size() * ( sizeof ( Primitive ) + ( 6 * sizeof ( double ) ) + ( 2 * sizeof ( void * ) ) ) );
+		this->_noteMemory ( treeBytes + ( hits.capacity() * sizeof ( IntersectionData ) ) );
+	}
+
+	// The hits have copies of what we need from the triangles.
+	if ( _lowMemory )
+	{
+		_triangles = Triangles();
+	}
 
 	// Initialize.
-	typedef std::map < std::string, LineSegment > LineSegmentMap;
 	LineSegmentMap lsm;
 	LineSegments lines;
+	std::size_t mapBytes = 0;
 
 	// Loop through the hits.
 	for ( const auto &hit : hits )
@@ -494,11 +1144,13 @@ void Terrain::_intersect()
 		// Get the line segment.
 		const LineSegment &line = boost::get < LineSegment > ( variant );
 
-		// This is our map key.
-		const std::string key = Details::makeMapKey ( line );
-
-		// Save the line segment in our map.
-		lsm[key] = line;
+		// Save the line segment in our map. About what a new map node holds,
+		// with its key, parent, and children.
+		const auto result = Terrain::addLineSegment ( line, lsm );
+		if ( result.second )
+		{
+			mapBytes += ( sizeof ( LineSegmentMap::value_type ) + result.first->first.capacity() + ( 4 * sizeof ( void * ) ) );
+		}
 
 		#if 0
 		#ifdef _DEBUG
@@ -511,10 +1163,17 @@ void Terrain::_intersect()
 		#endif
 	}
 
+	// The hits are all in the map now.
+	this->_noteMemory ( mapBytes + ( hits.capacity() * sizeof ( IntersectionData ) ) );
+	if ( _lowMemory )
+	{
+		std::vector < IntersectionData > ().swap ( hits );
+	}
+
 	// We need to clip the lines with two planes, one at each end of the path.
 	// These are the two points at the start and end of the path.
-	const Point &p1 = _points.at ( this->_getIndex ( _i1, _j1 ) );
-	const Point &p2 = _points.at ( this->_getIndex ( _i2, _j2 ) );
+	const Point &p1 = _start;
+	const Point &p2 = _end;
 
 	// The normal vectors.
 	const Vector n1 = ( p1 - p2 );
@@ -542,21 +1201,28 @@ void Terrain::_intersect()
 		}
 	}
 
-	// Set the line segments.
-	_lines = lines;
+	// Set the line segments. Moving does not hold two copies.
+	this->_noteMemory ( mapBytes + ( lines.capacity() * sizeof ( LineSegment ) ) );
+	_lines = std::move ( lines );
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-//	Get the distance along the path.
+//	Get the distance along the path, and whatever else the accumulator
+//	measures in the same pass.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-double Terrain::_getPathDistances() const
+template < class Accumulator > Terrain::Metrics Terrain::_getPathDistances() const
 {
-	// Initialize the distance.
-	double dist = 0;
+	// Each line segment is turned to point the same way as the path.
+	typedef PathMetrics::Step < LineSegment > Step;
+	const double dirX = ( _end[0] - _start[0] );
+	const double dirY = ( _end[1] - _start[1] );
+
+	// Initialize the accumulators.
+	Accumulator accumulator;
 
 	// Loop through the lines in the container.
 	for ( const auto &line : _lines )
@@ -571,12 +1237,48 @@ double Terrain::_getPathDistances() const
 		#endif
 		#endif
 
-		// Add to the distance.
-		dist += std::sqrt ( line.squared_length() );
+		// Add to the distance and the rest.
+		accumulator.add ( Step ( line, dirX, dirY ) );
 	}
 
-	// Return the total distance.
-	return dist;
+	// Return what we measured.
+	Metrics metrics;
+	accumulator.get ( metrics );
+	return metrics;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Find the path if we have not yet, and measure it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+template < class Accumulator > void Terrain::_measure()
+{
+	// Run through all the steps to find the path, unless we already have.
+	if ( _dist < 0 )
+	{
+		this->_findPath();
+	}
+
+	// Measure it.
+	const Metrics metrics = this->_getPathDistances < Accumulator > ();
+	_dist = metrics.distance;
+
+	// We only needed the lines for the measurements.
+	if ( _lowMemory )
+	{
+		_lines = LineSegments();
+	}
+	this->_recordStage ( STAGE_DISTANCE );
+
+	// Save all of them when we have all of them.
+	if ( std::is_same < Accumulator, PathMetrics::All >::value )
+	{
+		_metrics = metrics;
+		_hasMetrics = true;
+	}
 }
 
 
@@ -591,13 +1293,37 @@ double Terrain::getDistance()
 	// Is this the first time?
 	if ( _dist < 0 )
 	{
-		// Run through all the steps to find the path.
-		this->_findPath();
-
-		// Set the new distance.
-		_dist = this->_getPathDistances();
+		// The lines are freed in low-memory mode, so measure everything
+		// while we have them.
+		if ( _lowMemory )
+		{
+			this->_measure < PathMetrics::All > ();
+		}
+		else
+		{
+			this->_measure < PathMetrics::DistanceOnly > ();
+		}
 	}
 
 	// Return what we have.
 	return _dist;
 }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the distance, climb, descent, and slope along the path.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+const Terrain::Metrics &Terrain::getMetrics()
+{
+	// Is this the first time?
+	if ( !_hasMetrics )
+	{
+		this->_measure < PathMetrics::All > ();
+	}
+
+	// Return what we have.
+	return _metrics;
+}
@@ -6,11 +6,22 @@
 
 #pragma once
 
+#include "Constants.h"
+#include "HeightGrid.h"
+#include "PathMetrics.h"
+
 #include "CGAL/Simple_cartesian.h"
 
 #include "Eigen/Geometry"
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 
@@ -31,14 +42,57 @@ public:
 	typedef Kernel::Triangle_3 Triangle;
 	typedef Eigen::Vector2 < unsigned int > Vec2ui;
 
-	typedef std::vector < std::uint8_t > Heights;
+	typedef HeightGrid::Heights Heights;
+	typedef HeightGrid::HeightsView HeightsView;
+	typedef HeightGrid::Index Index;
 	typedef std::vector < Point > Points;
 	typedef std::vector < Triangle > Triangles;
 	typedef std::vector < LineSegment > LineSegments;
-
-	// This is the only constructor we want.
+	typedef std::map < std::string, LineSegment > LineSegmentMap;
+	typedef PathMetrics::Metrics Metrics;
+
+	// Thrown when the path can not be measured because of where it is,
+	// rather than because something went wrong.
+	class GeometryError : public std::runtime_error
+	{
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	// The first and last column of cells in each row of the corridor. The
+	// row is empty when the first is past the last.
+	typedef std::vector < std::pair < unsigned int, unsigned int > > ColumnRanges;
+
+	// The stages of finding the path.
+	enum Stage
+	{
+		STAGE_POINTS,
+		STAGE_TRIANGLES,
+		STAGE_INTERSECT,
+		STAGE_DISTANCE,
+		NUM_STAGES
+	};
+	typedef std::array < std::size_t, NUM_STAGES > StageMemory;
+
+	// The size of a cell and of one step in height, in meters, when the
+	// input does not say, and the version of the answers. See Constants.h.
+	static constexpr double DEFAULT_HORIZONTAL_RESOLUTION = Constants::DEFAULT_HORIZONTAL_RESOLUTION;
+	static constexpr double DEFAULT_VERTICAL_RESOLUTION = Constants::DEFAULT_VERTICAL_RESOLUTION;
+	static constexpr unsigned int ENGINE_VERSION = Constants::ENGINE_VERSION;
+
+	// Construct from a file of heights.
 	Terrain ( unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, const std::string & );
 
+	// Construct from heights owned by the caller. They are not copied,
+	// so they have to outlive this object.
+	Terrain ( unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, HeightsView );
+
+	// Construct from heights that are moved into this object.
+	Terrain ( unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, Heights && );
+
+	// Construct from a grid of heights that is moved into this object.
+	Terrain ( unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, HeightGrid && );
+
 	// The default destructor is fine.
 	~Terrain() = default;
 
@@ -56,23 +110,78 @@ public:
 	const double &getDistance() const { return _dist; };
 	double getDistance();
 
+	// Get the distance, climb, descent, and slope along the path. They are
+	// all found in the same pass as the distance. In low-memory mode the
+	// lines are freed after that pass, so getDistance() finds them all too.
+	const Metrics &getMetrics();
+
+	// Set the size of a cell and of one step in height, in meters.
+	double getHorizontalResolution() const { return _horizontalResolution; }
+	double getVerticalResolution() const { return _verticalResolution; }
+	void setResolution ( double horizontal, double vertical );
+
+	// Set the low-memory mode. When on, each stage frees what it no longer
+	// needs, heights are streamed from the file when we have one, and the
+	// most bytes each stage holds at once is recorded.
+	bool getLowMemory() const { return _lowMemory; }
+	void setLowMemory ( bool );
+
+	// Set the corridor mode. When on, which is the default, the mesh is
+	// only made for the cells near the path that could be part of it. The
+	// answer is the same as with the whole mesh.
+	bool getCorridor() const { return _corridor; }
+	void setCorridor ( bool );
+
+	// Get how many cells from the path from [i1,j1] to [i2,j2] the corridor
+	// can reach, given the lowest and highest ground in meters. Heights
+	// farther away than this are not needed in corridor mode.
+	static double getCorridorMargin ( unsigned int i1, unsigned int j1, unsigned int i2, unsigned int j2, double zMin, double zMax, double horizontalResolution );
+
+	// Get the most bytes each stage held at once in low-memory mode. This is
+	// what this query owns, not the whole process, so it is the same on
+	// every system and does not include other threads.
+	const StageMemory &getStageMemory() const { return _stageMemory; }
+	static const char *getStageName ( Stage );
+
+	// Add the line segment to the map, keyed by its rounded end points.
+	// When another one already has the key the lesser one is kept, so the
+	// map is the same in any order. Returns what std::map::insert does.
+	static std::pair < LineSegmentMap::iterator, bool > addLineSegment ( const LineSegment &, LineSegmentMap & );
+
 protected:
 
-	void _addTriangleRow ( unsigned int rowA, unsigned int rowB, Triangles &triangles ) const;
-	void _addTwoTriangles ( unsigned int rowA, unsigned int rowB, unsigned int colA, unsigned int colB, Triangles &triangles ) const;
+	template < class IndexType > void _addTriangleRows ( Triangles &triangles ) const;
+	template < class IndexType > void _addTriangleRow ( unsigned int rowA, unsigned int rowB, Triangles &triangles ) const;
+	template < class IndexType > void _addTwoTriangles ( unsigned int rowA, unsigned int rowB, unsigned int colA, unsigned int colB, Triangles &triangles ) const;
+
+	void _checkInput() const;
 
 	void _findPath();
 
-	unsigned int _getIndex ( unsigned int i, unsigned int j ) const;
-	double _getPathDistances() const;
+	Heights::value_type _getHeight ( unsigned int i, unsigned int j ) const;
+	void _getHeightRange ( double &zMin, double &zMax ) const;
+
+	template < class IndexType > IndexType _getIndex ( unsigned int i, unsigned int j ) const;
+	Index _getNumCells() const;
+	template < class Accumulator > Metrics _getPathDistances() const;
 
 	void _intersect();
 
+	void _makeCorridor();
+	void _makeCorridorPoints();
+	void _makeCorridorTriangles();
 	void _makeGroundPoints();
 	void _makeTriangles();
 	void _makePlane();
+	Point _makePoint ( unsigned int i, unsigned int j, Heights::value_type height ) const;
+
+	void _readRow ( std::ifstream &in, unsigned int i, unsigned int first, Heights &heights ) const;
+
+	template < class Accumulator > void _measure();
 
-	void _readHeightData ( std::ifstream & );
+	std::size_t _getOwnedBytes() const;
+	void _noteMemory ( std::size_t extra );
+	void _recordStage ( Stage );
 
 private:
 
@@ -82,10 +191,22 @@ private:
 	unsigned int _j1;
 	unsigned int _i2;
 	unsigned int _j2;
-	Heights _heights;
+	std::string _input;
+	bool _lowMemory;
+	bool _corridor;
+	double _horizontalResolution;
+	double _verticalResolution;
+	HeightGrid _heights;
+	ColumnRanges _columns;
 	Points _points;
 	Triangles _triangles;
 	Plane _plane;
+	Point _start;
+	Point _end;
 	LineSegments _lines;
 	double _dist;
+	Metrics _metrics;
+	bool _hasMetrics;
+	StageMemory _stageMemory;
+	std::size_t _stagePeak;
 };
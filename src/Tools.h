@@ -6,8 +6,14 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
 #include <sstream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -43,6 +49,99 @@ inline unsigned int getUint ( const char *str )
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Safely return a 64-bit unsigned int.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline std::uint64_t getUint64 ( const std::string &str )
+{
+	if ( str.empty() || ( std::string::npos != str.find_first_not_of ( "0123456789" ) ) )
+	{
+		throw std::runtime_error ( "String is invalid unsigned int: " + str );
+	}
+
+	try
+	{
+		return static_cast < std::uint64_t > ( std::stoull ( str ) );
+	}
+	catch ( const std::out_of_range & )
+	{
+		throw std::runtime_error ( "String is too big for unsigned int: " + str );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Hash the bytes with 64-bit FNV-1a. Pass the previous answer as the last
+//	argument to hash more bytes.
+//	https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline std::uint64_t hash ( const void *data, std::size_t size, std::uint64_t answer = 0xcbf29ce484222325ull )
+{
+	const unsigned char *bytes = static_cast < const unsigned char * > ( data );
+	for ( std::size_t i = 0; i < size; ++i )
+	{
+		answer ^= bytes[i];
+		answer *= 0x100000001b3ull;
+	}
+	return answer;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The command-line arguments. Options look like "--name" or "--name=value"
+//	and can be anywhere. Everything else is positional.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct Arguments
+{
+	std::vector < std::string > positional;
+	std::map < std::string, std::string > options;
+
+	bool hasOption ( const std::string &name ) const
+	{
+		return ( options.end() != options.find ( name ) );
+	}
+
+	std::string getOption ( const std::string &name, const std::string &defaultValue = std::string() ) const
+	{
+		const auto itr = options.find ( name );
+		return ( ( options.end() == itr ) ? defaultValue : itr->second );
+	}
+};
+
+inline Arguments getArguments ( int argc, char **argv )
+{
+	Arguments args;
+
+	for ( int i = 1; i < argc; ++i )
+	{
+		const std::string arg ( argv[i] );
+
+		if ( 0 == arg.compare ( 0, 2, "--" ) )
+		{
+			const std::string::size_type equals = arg.find ( '=' );
+			const std::string name = arg.substr ( 2, equals - 2 );
+			const std::string value = ( ( std::string::npos == equals ) ? std::string() : arg.substr ( equals + 1 ) );
+			args.options[name] = value;
+		}
+		else
+		{
+			args.positional.push_back ( arg );
+		}
+	}
+
+	return args;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //	Format the vectors.
@@ -0,0 +1,269 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Program for converting a raw file of heights to a tiled height map file,
+//	or for writing the changes between two height maps to a delta file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "Constants.h"
+#include "HeightMapDelta.h"
+#include "HeightMapFile.h"
+#include "Tools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the value as a count from one to the largest unsigned int. The name
+//	says which argument was bad when it is not.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline unsigned int getCount ( const std::string &value, const std::string &name )
+{
+	std::uint64_t answer = 0;
+	try
+	{
+		answer = Tools::getUint64 ( value );
+	}
+	catch ( const std::exception &e )
+	{
+		throw std::runtime_error ( "Invalid " + name + ": " + e.what() );
+	}
+
+	if ( ( 0 == answer ) || ( answer > std::numeric_limits < unsigned int >::max() ) )
+	{
+		std::ostringstream out;
+		out << "Invalid " << name << ": " << value << " is not from 1 to " << std::numeric_limits < unsigned int >::max();
+		throw std::runtime_error ( out.str() );
+	}
+
+	return static_cast < unsigned int > ( answer );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the option as a number greater than zero, or the default if it is
+//	not there.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline double getDouble ( const Tools::Arguments &args, const std::string &name, double defaultValue )
+{
+	if ( !args.hasOption ( name ) )
+	{
+		return defaultValue;
+	}
+
+	const std::string value = args.getOption ( name );
+	std::size_t used = 0;
+	double answer = 0;
+	try
+	{
+		answer = std::stod ( value, &used );
+	}
+	catch ( const std::exception & )
+	{
+		used = 0;
+	}
+
+	if ( value.empty() || ( used != value.size() ) || !std::isfinite ( answer ) || !( answer > 0 ) )
+	{
+		throw std::runtime_error ( "Invalid --" + name + ": " + value + " is not a number greater than zero" );
+	}
+	return answer;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Read the heights from a tiled height map file or a raw file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline HeightGrid readHeights ( unsigned int numX, unsigned int numY, const std::string &input )
+{
+	if ( !HeightMapFile::isHeightMapFile ( input ) )
+	{
+		return HeightGrid::read ( numX, numY, input );
+	}
+
+	HeightMapFile file ( input );
+	if ( ( file.getHeader().numX != numX ) || ( file.getHeader().numY != numY ) )
+	{
+		throw std::runtime_error ( "Size of height map file " + input + " does not match the given size" );
+	}
+	return file.readAll();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Are the heights the same? The segments do not have to line up.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline bool isSame ( const HeightGrid &a, const HeightGrid &b )
+{
+	if ( ( a.getNumX() != b.getNumX() ) || ( a.getNumY() != b.getNumY() ) )
+	{
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < a.getNumY(); ++i )
+	{
+		const HeightGrid::HeightsView rowA = a.getRow ( i );
+		const HeightGrid::HeightsView rowB = b.getRow ( i );
+		if ( !std::equal ( rowA.begin(), rowA.end(), rowB.begin() ) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Write the changes from the base height map to the after one.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void runDelta ( const Tools::Arguments &args )
+{
+	const unsigned int numX = getCount ( args.positional[0], "num x" );
+	const unsigned int numY = getCount ( args.positional[1], "num y" );
+
+	const std::string input1 = args.positional[2];
+	const std::string input2 = args.positional[3];
+	const std::string output = args.positional[4];
+
+	std::cout << "Comparing input files: " << input1 << " and " << input2 << std::endl;
+	const HeightGrid base = readHeights ( numX, numY, input1 );
+	const HeightGrid after = readHeights ( numX, numY, input2 );
+	const HeightMapDelta::Header header = HeightMapDelta::write ( output, base, after );
+
+	// Apply it to make sure it is good.
+	HeightMapDelta delta ( output );
+	if ( !isSame ( delta.apply ( base ), after ) )
+	{
+		throw std::runtime_error ( "Heights made from " + output + " do not match the input" );
+	}
+
+	std::cout << "Wrote " << header.numChanged << " changed heights in " << header.numRuns << " runs to: " << output << std::endl;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Convert the raw file to a tiled height map file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void runConvert ( const Tools::Arguments &args )
+{
+	const unsigned int numX = getCount ( args.positional[0], "num x" );
+	const unsigned int numY = getCount ( args.positional[1], "num y" );
+
+	const std::string input = args.positional[2];
+	const std::string output = args.positional[3];
+
+	HeightMapFile::Header header;
+	header.numX = numX;
+	header.numY = numY;
+	header.tileSize = getCount ( args.getOption ( "tile-size", "256" ), "--tile-size" );
+	header.horizontalResolution = getDouble ( args, "horizontal-resolution", Constants::DEFAULT_HORIZONTAL_RESOLUTION );
+	header.verticalResolution = getDouble ( args, "vertical-resolution", Constants::DEFAULT_VERTICAL_RESOLUTION );
+
+	std::cout << "Converting input file: " << input << std::endl;
+	const HeightGrid heights = HeightGrid::read ( numX, numY, input );
+	HeightMapFile::write ( output, header, heights );
+
+	// Read it back to make sure it is good.
+	HeightMapFile file ( output );
+	if ( !isSame ( file.readAll(), heights ) )
+	{
+		throw std::runtime_error ( "Heights read back from " + output + " do not match the input" );
+	}
+
+	std::cout << "Wrote " << file.getNumTilesX() << " by " << file.getNumTilesY() << " tiles to: " << output << std::endl;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Run the program.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void run ( const Tools::Arguments &args )
+{
+	if ( args.hasOption ( "delta" ) )
+	{
+		runDelta ( args );
+	}
+	else
+	{
+		runConvert ( args );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Main function.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char **argv )
+{
+	// Separate the options from the other arguments.
+	const Tools::Arguments args = Tools::getArguments ( argc, argv );
+
+	// Check input.
+	const std::size_t numPositional = ( args.hasOption ( "delta" ) ? 5 : 4 );
+	if ( args.positional.size() < numPositional )
+	{
+		std::cerr << "Usage: " << argv[0] << " [options] <num x> <num y> <raw input file> <output file>" << std::endl;
+		std::cerr << "       " << argv[0] << " --delta <num x> <num y> <input file before> <input file after> <output file>" << std::endl;
+		std::cerr << "Options:" << std::endl;
+		std::cerr << "  --delta                        Write the changes from the before height map to the after one" << std::endl;
+		std::cerr << "  --tile-size=<n>                Number of cells on each side of a tile, the default is 256" << std::endl;
+		std::cerr << "  --horizontal-resolution=<m>    Size of a cell in meters, the default is 30" << std::endl;
+		std::cerr << "  --vertical-resolution=<m>      Size of one step in height in meters, the default is 11" << std::endl;
+		return 1;
+	}
+
+	// Safely run the program.
+	try
+	{
+		run ( args );
+	}
+
+	// Catch standard exceptions.
+	catch ( const std::exception &e )
+	{
+		std::cerr << "Exception caught: " << e.what() << std::endl;
+		return 1;
+	}
+
+	// Catch all other exceptions.
+	catch ( ... )
+	{
+		std::cerr << "Unknown exception caught" << std::endl;
+		return 1;
+	}
+
+	// If we get to here then it worked.
+	return 0;
+}
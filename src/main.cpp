@@ -4,11 +4,163 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-#include "Terrain.h"
+#include "PathDistance.h"
 #include "Tools.h"
 
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Types used below.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+typedef std::array < unsigned int, 2 > Vec2ui;
+typedef std::unique_ptr < PathDistanceSurface, decltype ( &pathDistanceSurfaceFree ) > SurfacePtr;
+typedef std::unique_ptr < PathDistanceCache, decltype ( &pathDistanceCacheFree ) > CachePtr;
+
+// A height map that is ready to measure, or the answer from the cache. The
+// first one can have both when the deltas need it.
+struct Epoch
+{
+	SurfacePtr surface { nullptr, &pathDistanceSurfaceFree };
+	bool cached = false;
+	double dist = -1;
+	PathDistanceMetrics metrics = {};
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Throw if the library call failed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void checkStatus ( int status )
+{
+	if ( PATH_DISTANCE_OK != status )
+	{
+		throw std::runtime_error ( pathDistanceGetLastError() );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Load the surface from the file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline SurfacePtr loadSurface ( unsigned int numX, unsigned int numY, const std::string &input, bool lowMemory )
+{
+	PathDistanceSurface *raw = nullptr;
+	checkStatus ( lowMemory ?
+		pathDistanceSurfaceOpenFile ( numX, numY, input.c_str(), &raw ) :
+		pathDistanceSurfaceLoadFile ( numX, numY, input.c_str(), &raw )
+	);
+	return SurfacePtr ( raw, &pathDistanceSurfaceFree );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Is the file a delta file?
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline bool isDeltaFile ( const std::string &input )
+{
+	return ( 1 == pathDistanceIsDeltaFile ( input.c_str() ) );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Load the surface from the base surface and the delta file.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline SurfacePtr loadDelta ( const PathDistanceSurface *base, const std::string &input )
+{
+	PathDistanceSurface *raw = nullptr;
+	checkStatus ( pathDistanceSurfaceLoadDelta ( base, input.c_str(), &raw ) );
+	return SurfacePtr ( raw, &pathDistanceSurfaceFree );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Print the peak memory of each stage.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void printStageMemory ( const PathDistanceMemoryReport &report )
+{
+	for ( int i = 0; i < PATH_DISTANCE_NUM_STAGES; ++i )
+	{
+		const double mb = static_cast < double > ( report.peakMemory[i] ) / ( 1024 * 1024 );
+		std::cout << "Peak memory in stage " << pathDistanceGetStageName ( i ) << ": " << mb << " MB" << std::endl;
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Find the distance along the path. In low-memory mode also print the
+//	peak memory of each stage.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline double getDistance ( const PathDistanceSurface *surface, const Vec2ui &index1, const Vec2ui &index2, bool lowMemory )
+{
+	double dist = -1;
+
+	if ( !lowMemory )
+	{
+		checkStatus ( pathDistanceQuery ( surface, index1[0], index1[1], index2[0], index2[1], &dist ) );
+		return dist;
+	}
+
+	PathDistanceMemoryReport report;
+	checkStatus ( pathDistanceQueryLowMemory ( surface, index1[0], index1[1], index2[0], index2[1], &dist, &report ) );
+	printStageMemory ( report );
+
+	return dist;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Find the metrics along the path. In low-memory mode also print the
+//	peak memory of each stage.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline PathDistanceMetrics getMetrics ( const PathDistanceSurface *surface, const Vec2ui &index1, const Vec2ui &index2, bool lowMemory )
+{
+	PathDistanceMetrics metrics = {};
+
+	if ( !lowMemory )
+	{
+		checkStatus ( pathDistanceQueryMetrics ( surface, index1[0], index1[1], index2[0], index2[1], &metrics ) );
+		return metrics;
+	}
+
+	PathDistanceMemoryReport report;
+	checkStatus ( pathDistanceQueryMetricsLowMemory ( surface, index1[0], index1[1], index2[0], index2[1], &metrics, &report ) );
+	printStageMemory ( report );
+
+	return metrics;
+}
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -17,11 +169,8 @@
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-inline void printAnswer ( const std::string &input, const Terrain &t )
+inline void printAnswer ( const Vec2ui &index1, const Vec2ui &index2, double dist )
 {
-	const Terrain::Vec2ui index1 = t.getPathStart();
-	const Terrain::Vec2ui index2 = t.getPathEnd();
-	const double &dist = t.getDistance();
 	std::cout << "Path distance from: [";
 	std::cout << Tools::formatVec2 ( index1, "," );
 	std::cout << "] to [";
@@ -33,34 +182,309 @@ inline void printAnswer ( const std::string &input, const Terrain &t )
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-//	Run the program.
+//	Print the metrics other than the distance. For the changes from one
+//	height map to the next the names start with "Change in".
 //
 ////////////////////////////////////////////////////////////////////////////////
 
-inline void run ( int argc, char **argv )
+inline void printMetrics ( const PathDistanceMetrics &metrics, bool change )
 {
-	const unsigned int numX = Tools::getUint ( argv[1] );
-	const unsigned int numY = Tools::getUint ( argv[2] );
-	const unsigned int i1   = Tools::getUint ( argv[3] );
-	const unsigned int j1   = Tools::getUint ( argv[4] );
-	const unsigned int i2   = Tools::getUint ( argv[5] );
-	const unsigned int j2   = Tools::getUint ( argv[6] );
+	auto name = [&] ( const std::string &text )
+	{
+		return ( change ? ( "Change in " + text ) : ( static_cast < char > ( std::toupper ( text[0] ) ) + text.substr ( 1 ) ) );
+	};
+
+	std::cout << name ( "horizontal distance" ) << ": " << metrics.horizontalDistance << " m" << std::endl;
+	std::cout << name ( "ascent" ) << ": " << metrics.ascent << " m" << std::endl;
+	std::cout << name ( "descent" ) << ": " << metrics.descent << " m" << std::endl;
+	std::cout << name ( "maximum slope" ) << ": " << metrics.maxSlope << std::endl;
+	std::cout << name ( "horizontal to surface ratio" ) << ": " << metrics.horizontalRatio << std::endl;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Get the change in the metrics, after minus before.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline PathDistanceMetrics getChange ( const PathDistanceMetrics &before, const PathDistanceMetrics &after )
+{
+	PathDistanceMetrics change;
+	change.distance = ( after.distance - before.distance );
+	change.horizontalDistance = ( after.horizontalDistance - before.horizontalDistance );
+	change.ascent = ( after.ascent - before.ascent );
+	change.descent = ( after.descent - before.descent );
+	change.maxSlope = ( after.maxSlope - before.maxSlope );
+	change.horizontalRatio = ( after.horizontalRatio - before.horizontalRatio );
+	return change;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Summarize the change in distance along random paths.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void runSampling ( const Tools::Arguments &args )
+{
+	const unsigned int numX = Tools::getUint ( args.positional[0].c_str() );
+	const unsigned int numY = Tools::getUint ( args.positional[1].c_str() );
+
+	const std::string input1 = args.positional[2];
+	const std::string input2 = args.positional[3];
+
+	const std::uint64_t numSamples = Tools::getUint64 ( args.getOption ( "samples" ) );
+	const std::uint64_t seed = Tools::getUint64 ( args.getOption ( "seed", "1" ) );
+	const unsigned int numThreads = static_cast < unsigned int > ( Tools::getUint64 ( args.getOption ( "threads", "0" ) ) );
 
-	const std::string input1 = argv[7];
-	const std::string input2 = argv[8];
+	const bool lowMemory = args.hasOption ( "low-memory" );
+	SurfacePtr before = loadSurface ( numX, numY, input1, lowMemory );
+	SurfacePtr after = ( isDeltaFile ( input2 ) ?
+		loadDelta ( before.get(), input2 ) :
+		loadSurface ( numX, numY, input2, lowMemory )
+	);
 
-	std::cout << "Processing input file: " << input1 << std::endl;
-	Terrain t1 ( numX, numY, i1, j1, i2, j2, input1 );
-	const double d1 = t1.getDistance();
-	printAnswer ( input1, t1 );
+	// The whole mesh gives the same answers, but it can be asked for.
+	if ( args.hasOption ( "full-mesh" ) )
+	{
+		checkStatus ( pathDistanceSurfaceSetCorridor ( before.get(), 0 ) );
+		checkStatus ( pathDistanceSurfaceSetCorridor ( after.get(), 0 ) );
+	}
+
+	const std::vector < double > quantiles = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+	std::vector < double > values ( quantiles.size() );
+	PathDistanceSampleStats stats;
 
-	std::cout << "Processing input file: " << input2 << std::endl;
-	Terrain t2 ( numX, numY, i1, j1, i2, j2, input2 );
-	const double d2 = t2.getDistance();
-	printAnswer ( input2, t2 );
+	checkStatus ( pathDistanceSample (
+		before.get(), after.get(),
+		static_cast < size_t > ( numSamples ), seed, numThreads,
+		&stats, quantiles.data(), quantiles.size(), values.data()
+	) );
 
-	const double dd = std::fabs ( d1 - d2 );
-	std::cout << "Change in distance: " << dd << " m" << std::endl;
+	std::cout << "Sampled " << numSamples << " random paths with seed " << seed << std::endl;
+	std::cout << "Paths measured: " << stats.count << ", failed: " << stats.failures << std::endl;
+	if ( stats.count > 0 )
+	{
+		std::cout << "Change in distance mean: " << stats.mean << " m" << std::endl;
+		std::cout << "Change in distance standard deviation: " << std::sqrt ( stats.variance ) << " m" << std::endl;
+		std::cout << "Change in distance range: [" << stats.min << "," << stats.max << "] m" << std::endl;
+		for ( std::size_t i = 0; i < quantiles.size(); ++i )
+		{
+			std::cout << "Change in distance " << ( quantiles[i] * 100 ) << "% quantile: " << values[i] << " m" << std::endl;
+		}
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Find the change in distance along the given path over the height maps,
+//	which are in time order. The next height map is read while the current
+//	one is measured, so at most two are in memory at once. Any of them after
+//	the first can be a delta file of the changes to the first one, which is
+//	then kept as well.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void runPath ( const Tools::Arguments &args )
+{
+	const unsigned int numX = Tools::getUint ( args.positional[0].c_str() );
+	const unsigned int numY = Tools::getUint ( args.positional[1].c_str() );
+	const unsigned int i1   = Tools::getUint ( args.positional[2].c_str() );
+	const unsigned int j1   = Tools::getUint ( args.positional[3].c_str() );
+	const unsigned int i2   = Tools::getUint ( args.positional[4].c_str() );
+	const unsigned int j2   = Tools::getUint ( args.positional[5].c_str() );
+
+	const std::vector < std::string > inputs ( args.positional.begin() + 6, args.positional.end() );
+
+	const Vec2ui index1 = { i1, j1 };
+	const Vec2ui index2 = { i2, j2 };
+
+	const bool lowMemory = args.hasOption ( "low-memory" );
+	const bool metrics = args.hasOption ( "metrics" );
+	const bool fullMesh = args.hasOption ( "full-mesh" );
+
+	// Open the cache if we were given one.
+	CachePtr cache ( nullptr, &pathDistanceCacheFree );
+	if ( args.hasOption ( "cache" ) )
+	{
+		PathDistanceCache *raw = nullptr;
+		checkStatus ( pathDistanceCacheOpen ( args.getOption ( "cache" ).c_str(), &raw ) );
+		cache.reset ( raw );
+	}
+
+	// The deltas are all against the first height map.
+	auto isDelta = [&] ( std::size_t k )
+	{
+		return ( ( k > 0 ) && isDeltaFile ( inputs[k] ) );
+	};
+	bool hasDeltas = false;
+	for ( std::size_t k = 1; k < inputs.size(); ++k )
+	{
+		hasDeltas = ( hasDeltas || isDelta ( k ) );
+	}
+	SurfacePtr base ( nullptr, &pathDistanceSurfaceFree );
+
+	// Look in the cache, and only read the height map when it's not there.
+	// The first height map is read anyway when the deltas need it. The
+	// cache only has the distance, so it is not used for the metrics.
+	auto load = [&] ( std::size_t k )
+	{
+		const std::string &input = inputs[k];
+		const bool delta = isDelta ( k );
+
+		Epoch epoch;
+		int found = 0;
+		if ( cache && !metrics )
+		{
+			// The surface would have the resolution of the file, which is
+			// what zero means here. A delta has the resolution of the first.
+			double horizontal = 0, vertical = 0;
+			if ( delta )
+			{
+				checkStatus ( pathDistanceSurfaceGetResolution ( base.get(), &horizontal, &vertical ) );
+			}
+			checkStatus ( pathDistanceCacheFind ( cache.get(), input.c_str(), numX, numY, horizontal, vertical, i1, j1, i2, j2, &epoch.dist, &found ) );
+		}
+		epoch.cached = ( 0 != found );
+		if ( !epoch.cached || ( ( 0 == k ) && hasDeltas ) )
+		{
+			epoch.surface = ( delta ?
+				loadDelta ( base.get(), input ) :
+				loadSurface ( numX, numY, input, lowMemory )
+			);
+			if ( fullMesh )
+			{
+				checkStatus ( pathDistanceSurfaceSetCorridor ( epoch.surface.get(), 0 ) );
+			}
+		}
+		return epoch;
+	};
+
+	// Start reading the first one.
+	std::future < Epoch > next = std::async ( std::launch::async, load, 0 );
+
+	// Loop over the height maps.
+	std::vector < double > distances;
+	std::vector < PathDistanceMetrics > allMetrics;
+	for ( std::size_t k = 0; k < inputs.size(); ++k )
+	{
+		// Wait for this one to be read.
+		Epoch epoch = next.get();
+
+		// Keep the first one for the deltas before reading the next one.
+		const PathDistanceSurface *surface = epoch.surface.get();
+		if ( ( 0 == k ) && hasDeltas )
+		{
+			base = std::move ( epoch.surface );
+		}
+
+		// Start reading the next one.
+		if ( ( k + 1 ) < inputs.size() )
+		{
+			next = std::async ( std::launch::async, load, k + 1 );
+		}
+
+		std::cout << "Processing input file: " << inputs[k] << std::endl;
+		if ( ( nullptr != surface ) && !epoch.cached )
+		{
+			if ( metrics )
+			{
+				epoch.metrics = getMetrics ( surface, index1, index2, lowMemory );
+				epoch.dist = epoch.metrics.distance;
+			}
+			else
+			{
+				epoch.dist = getDistance ( surface, index1, index2, lowMemory );
+			}
+			if ( cache )
+			{
+				double horizontal = 0, vertical = 0;
+				checkStatus ( pathDistanceSurfaceGetResolution ( surface, &horizontal, &vertical ) );
+				checkStatus ( pathDistanceCacheInsert ( cache.get(), inputs[k].c_str(), numX, numY, horizontal, vertical, i1, j1, i2, j2, epoch.dist ) );
+			}
+		}
+		distances.push_back ( epoch.dist );
+		printAnswer ( index1, index2, distances.back() );
+		if ( metrics )
+		{
+			allMetrics.push_back ( epoch.metrics );
+			printMetrics ( allMetrics.back(), false );
+		}
+
+		if ( k > 0 )
+		{
+			const double dd = std::fabs ( distances[k] - distances[k - 1] );
+			std::cout << "Change in distance: " << dd << " m" << std::endl;
+			if ( metrics )
+			{
+				printMetrics ( getChange ( allMetrics[k - 1], allMetrics[k] ), true );
+			}
+		}
+	}
+
+	// With more than two we also print the series with the signed changes
+	// from the one before and from the first one.
+	if ( distances.size() > 2 )
+	{
+		std::cout << "Epoch, distance, change, cumulative change" << std::endl;
+		for ( std::size_t k = 0; k < distances.size(); ++k )
+		{
+			const double change = ( ( k > 0 ) ? ( distances[k] - distances[k - 1] ) : 0.0 );
+			const double cumulative = ( distances[k] - distances.front() );
+			std::cout << k << ", " << distances[k] << ", " << change << ", " << cumulative << std::endl;
+		}
+	}
+
+	// Say how well the cache did.
+	if ( cache )
+	{
+		size_t hits = 0, misses = 0;
+		checkStatus ( pathDistanceCacheGetStats ( cache.get(), &hits, &misses ) );
+		std::cout << "Cache hits: " << hits << ", misses: " << misses << std::endl;
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Run the program.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void run ( const Tools::Arguments &args )
+{
+	if ( args.hasOption ( "samples" ) )
+	{
+		runSampling ( args );
+	}
+	else
+	{
+		runPath ( args );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Print how to use the program.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+inline void printUsage ( const char *program )
+{
+	std::cerr << "Usage: " << program << " [options] <num x> <num y> <x1> <y1> <x2> <y2> <input file before> <input file after> [<more input files> ...]" << std::endl;
+	std::cerr << "       " << program << " --samples=<n> [options] <num x> <num y> <input file before> <input file after>" << std::endl;
+	std::cerr << "Options:" << std::endl;
+	std::cerr << "  --cache=<dir>   Save answers in the directory and use them again next time" << std::endl;
+	std::cerr << "  --full-mesh     Make the mesh for the whole height map instead of just near the path" << std::endl;
+	std::cerr << "  --low-memory    Free each stage as soon as it is used and print the peak memory of each stage" << std::endl;
+	std::cerr << "  --metrics       Also print the climb, descent, and slope along the path" << std::endl;
+	std::cerr << "  --samples=<n>   Summarize the change in distance along n random paths" << std::endl;
+	std::cerr << "  --seed=<n>      Seed for the random paths, the default is 1" << std::endl;
+	std::cerr << "  --threads=<n>   Threads for the random paths, the default is one for each core" << std::endl;
 }
 
 
@@ -72,17 +496,21 @@ inline void run ( int argc, char **argv )
 
 int main ( int argc, char **argv )
 {
+	// Separate the options from the other arguments.
+	const Tools::Arguments args = Tools::getArguments ( argc, argv );
+
 	// Check input.
-	if ( argc < 9 )
+	const std::size_t numPositional = ( args.hasOption ( "samples" ) ? 4 : 8 );
+	if ( args.positional.size() < numPositional )
 	{
-		std::cerr << "Usage: " << argv[0] << " <num x> <num y> <x1> <y1> <x2> <y2> <input file before> <input file after>" << std::endl;
+		printUsage ( argv[0] );
 		return 1;
 	}
 
 	// Safely run the program.
 	try
 	{
-		run ( argc, argv );
+		run ( args );
 	}
 
 	// Catch standard exceptions.
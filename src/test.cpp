@@ -0,0 +1,295 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Regression checks for the library. Run one check by name, or all of
+//	them with no arguments. Returns non-zero if any of them fail.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "HeightMapDelta.h"
+#include "Random.h"
+#include "Terrain.h"
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Helper functions.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+namespace { namespace Details
+{
+	typedef std::array < unsigned int, 4 > Path;
+	typedef std::vector < Path > Paths;
+
+	// The size of the grid. It is not square, so mixing up x and y shows.
+	const unsigned int NUM_X = 48;
+	const unsigned int NUM_Y = 40;
+
+	// Throw if the condition is false.
+	inline void check ( bool condition, const std::string &message )
+	{
+		if ( !condition )
+		{
+			throw std::runtime_error ( message );
+		}
+	}
+
+	// Make a fixed grid of rough heights. With the default resolution a
+	// step of one height is 11 meters over a 30 meter cell, so it is steep
+	// enough for the path to swing far from the straight line.
+	inline Terrain::Heights makeHeights()
+	{
+		Random random ( 1, 2 );
+		Terrain::Heights heights ( NUM_X * NUM_Y );
+		for ( unsigned int i = 0; i < NUM_Y; ++i )
+		{
+			for ( unsigned int j = 0; j < NUM_X; ++j )
+			{
+				const unsigned int ridge = ( ( j % 12 ) * 16 );
+				heights[ ( i * NUM_X ) + j ] = static_cast < std::uint8_t > ( ( ridge + random.next ( 64 ) ) % 256 );
+			}
+		}
+		return heights;
+	}
+
+	// Measure the path and write what we got, or the type of error we got.
+	inline std::string measure ( const Terrain::Heights &heights, const Path &path, bool corridor, bool lowMemory )
+	{
+		std::ostringstream out;
+		out << std::hexfloat;
+		try
+		{
+			Terrain terrain ( NUM_X, NUM_Y, path[0], path[1], path[2], path[3], Terrain::HeightsView ( heights ) );
+			terrain.setCorridor ( corridor );
+			terrain.setLowMemory ( lowMemory );
+			const Terrain::Metrics &metrics = terrain.getMetrics();
+			out << metrics.distance << ' ' << metrics.horizontalDistance << ' ';
+			out << metrics.ascent << ' ' << metrics.descent << ' ';
+			out << metrics.maxSlope << ' ' << metrics.horizontalRatio;
+		}
+		catch ( const std::exception &e )
+		{
+			out << "error " << typeid ( e ).name();
+		}
+		return out.str();
+	}
+
+	// Write the path for messages.
+	inline std::string format ( const Path &path )
+	{
+		std::ostringstream out;
+		out << '[' << path[0] << ',' << path[1] << "] to [" << path[2] << ',' << path[3] << ']';
+		return out.str();
+	}
+} }
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	The mesh in the corridor around the path gives the same answers as the
+//	whole mesh, or the same kind of error. The paths include the corners,
+//	the edges, short ones, end points outside of the grid, and random ones.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void testCorridor()
+{
+	using namespace Details;
+
+	const unsigned int lastX = NUM_X - 1;
+	const unsigned int lastY = NUM_Y - 1;
+
+	Paths paths = {
+		{ 0, 0, lastY, lastX },
+		{ 0, lastX, lastY, 0 },
+		{ lastY, lastX, 0, 0 },
+		{ 0, 0, 0, lastX },
+		{ 0, 0, lastY, 0 },
+		{ lastY, 0, lastY, lastX },
+		{ 0, lastX, lastY, lastX },
+		{ 0, 5, lastY, 7 },
+		{ 3, 0, 9, lastX },
+		{ 20, 20, 20, 21 },
+		{ 20, 20, 21, 20 },
+		{ 20, 20, 21, 22 },
+		{ 20, 20, 20, 20 },
+		{ 0, 0, NUM_Y, 4 },
+		{ 4, NUM_X, 10, 10 }
+	};
+
+	Random random ( 3, 4 );
+	for ( unsigned int k = 0; k < 100; ++k )
+	{
+		paths.push_back ( {
+			static_cast < unsigned int > ( random.next ( NUM_Y ) ),
+			static_cast < unsigned int > ( random.next ( NUM_X ) ),
+			static_cast < unsigned int > ( random.next ( NUM_Y ) ),
+			static_cast < unsigned int > ( random.next ( NUM_X ) ) } );
+	}
+
+	const Terrain::Heights heights = makeHeights();
+	unsigned int numMeasured = 0;
+
+	for ( const Path &path : paths )
+	{
+		const std::string expected = measure ( heights, path, false, false );
+		if ( 0 != expected.compare ( 0, 5, "error" ) )
+		{
+			++numMeasured;
+		}
+
+		check ( expected == measure ( heights, path, true, false ),
+			"Corridor answer differs for path " + format ( path ) );
+		check ( expected == measure ( heights, path, true, true ),
+			"Low-memory corridor answer differs for path " + format ( path ) );
+		check ( expected == measure ( heights, path, false, true ),
+			"Low-memory answer differs for path " + format ( path ) );
+	}
+
+	// Most of them have to have answers or this shows nothing.
+	check ( ( numMeasured * 2 ) > paths.size(), "Too few paths could be measured" );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Two line segments that round to the same map key give the same map
+//	whichever one comes first. The hits from the tree do not come in any
+//	set order, so without this the answer could change from run to run.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void testLineSegmentOrder()
+{
+	using namespace Details;
+
+	typedef Terrain::Point Point;
+	typedef Terrain::LineSegment LineSegment;
+	typedef Terrain::LineSegmentMap LineSegmentMap;
+
+	// These only differ past the digits in the key.
+	const LineSegment a ( Point ( 1000.0001, 2000, 300 ), Point ( 1030, 2010, 310 ) );
+	const LineSegment b ( Point ( 1000.0002, 2000, 300 ), Point ( 1030, 2010, 310 ) );
+	const LineSegment c ( Point ( 1030, 2010, 310 ), Point ( 1000.0002, 2000, 300 ) );
+
+	const std::vector < std::vector < LineSegment > > orders = {
+		{ a, b, c },
+		{ a, c, b },
+		{ b, a, c },
+		{ b, c, a },
+		{ c, a, b },
+		{ c, b, a }
+	};
+
+	for ( const std::vector < LineSegment > &order : orders )
+	{
+		LineSegmentMap lsm;
+		for ( const LineSegment &line : order )
+		{
+			Terrain::addLineSegment ( line, lsm );
+		}
+
+		check ( 1 == lsm.size(), "The line segments should make one key" );
+
+		const LineSegment &kept = lsm.begin()->second;
+		check ( ( kept[0] == a[0] ) && ( kept[1] == a[1] ), "The lesser line segment was not kept" );
+	}
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	A delta file gives the after heights back from the base heights, both
+//	when the base is a plain view and when it is a grid.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void testDelta()
+{
+	using namespace Details;
+
+	const Terrain::Heights base = makeHeights();
+	Terrain::Heights after = base;
+	Random random ( 5, 6 );
+	for ( unsigned int k = 0; k < 200; ++k )
+	{
+		after[random.next ( after.size() )] = static_cast < std::uint8_t > ( random.next ( 256 ) );
+	}
+
+	const std::string file = ( std::filesystem::temp_directory_path() / "path_distance_test.delta" ).string();
+	const HeightGrid baseGrid ( NUM_X, NUM_Y, Terrain::HeightsView ( base ) );
+	HeightMapDelta::write ( file, baseGrid, HeightGrid ( NUM_X, NUM_Y, Terrain::HeightsView ( after ) ) );
+
+	// Check that each row matches.
+	auto isAfter = [&] ( const HeightGrid &grid )
+	{
+		for ( unsigned int i = 0; i < NUM_Y; ++i )
+		{
+			const Terrain::HeightsView row = grid.getRow ( i );
+			if ( !std::equal ( row.begin(), row.end(), after.begin() + ( i * NUM_X ) ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	HeightMapDelta fromView ( file );
+	check ( isAfter ( fromView.apply ( Terrain::HeightsView ( base ) ) ), "Delta applied to a view is wrong" );
+
+	HeightMapDelta fromGrid ( file );
+	check ( isAfter ( fromGrid.apply ( baseGrid ) ), "Delta applied to a grid is wrong" );
+
+	std::filesystem::remove ( file );
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//	Main function.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int main ( int argc, char **argv )
+{
+	typedef std::pair < std::string, std::function < void() > > Test;
+	const std::vector < Test > tests = {
+		{ "corridor", &testCorridor },
+		{ "line_segment_order", &testLineSegmentOrder },
+		{ "delta", &testDelta }
+	};
+
+	int failures = 0;
+	for ( const Test &test : tests )
+	{
+		if ( ( argc > 1 ) && ( test.first != argv[1] ) )
+		{
+			continue;
+		}
+
+		try
+		{
+			test.second();
+			std::cout << "Passed: " << test.first << std::endl;
+		}
+		catch ( const std::exception &e )
+		{
+			std::cout << "Failed: " << test.first << ": " << e.what() << std::endl;
+			++failures;
+		}
+	}
+
+	return ( ( 0 == failures ) ? 0 : 1 );
+}